@@ -0,0 +1,50 @@
+/*
+ * Copyright 1991 by Stichting Mathematisch Centrum
+ * See `LICENCE' for more information.
+ */
+
+/* Interpreter memory allocation interface */
+
+#ifndef PY_ALLOC_H
+#define PY_ALLOC_H
+
+#include <python/std.h>
+
+struct py_env;
+struct py_allocator;
+
+/*
+ * All memory owned by objects, compiled code, parse trees and the
+ * tokenizer is allocated with these, which go through the allocation hooks
+ * of the current environment's interpreter (see `struct py_allocator') and
+ * count the bytes against that environment, until they are freed. They
+ * behave like their C library counterparts, except that an allocation
+ * which would take the environment over its limit fails.
+ * Memory from these must only be freed with `py_free' and vice versa.
+ */
+void* py_malloc(size_t);
+void* py_calloc(size_t, size_t);
+void* py_realloc(void*, size_t);
+void py_free(void*);
+
+/*
+ * Make an environment current, returning the previous one. `py_code_eval'
+ * does this for the duration of a call and `py_env_new' for the new
+ * environment, so this is only needed to pick which environment e.g.
+ * parsing and compiling are charged to.
+ */
+struct py_env* py_env_use(struct py_env*);
+
+/*
+ * Enter an environment into (or take it out of) the list of those memory
+ * is credited back to when freed; `py_env_new' and `py_env_delete' do
+ * this. Blocks charged to an environment which has been taken out are
+ * freed without credit.
+ */
+void py_alloc_attach(struct py_env*);
+void py_alloc_detach(struct py_env*);
+
+/* Fill in the C library for any hooks left NULL. */
+void py_allocator_default(struct py_allocator*);
+
+#endif
@@ -20,4 +20,13 @@ void py_close(void* fp);
 # define PY_FALLTHROUGH
 #endif
 
+/* Left undefined where we don't know how to ask for inlining. */
+#if defined(__GNUC__)
+# define PY_INLINE static __inline__
+#elif defined(_MSC_VER)
+# define PY_INLINE static __inline
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+# define PY_INLINE static inline
+#endif
+
 #endif
@@ -17,17 +17,41 @@ struct py_object* py_object_not(struct py_object*);
 
 struct py_object* py_object_neg(struct py_object*);
 
-struct py_object* py_object_add(struct py_object*, struct py_object*);
-struct py_object* py_object_sub(struct py_object*, struct py_object*);
+/* Dispatches through py_binary_ops */
+struct py_object* py_object_binary(
+		enum py_binary_op, struct py_object*, struct py_object*);
 
-struct py_object* py_object_mul(struct py_object*, struct py_object*);
-struct py_object* py_object_div(struct py_object*, struct py_object*);
-struct py_object* py_object_mod(struct py_object*, struct py_object*);
+/*
+ * As py_object_binary, but taking over the caller's reference to v. If that
+ * is the only reference, v may be updated in place and returned instead of
+ * a new object being made: strings and lists are extended by `+' and ints
+ * and floats take the result. py_object_binary_can_reuse tells whether
+ * this would happen for a v with no other references, in which case the
+ * operation can't fail bar running out of memory.
+ */
+struct py_object* py_object_binary_reuse(
+		enum py_binary_op, struct py_object*, struct py_object*);
+int py_object_binary_can_reuse(
+		enum py_binary_op, struct py_object*, struct py_object*);
 
-/* w[key] = v */
+/*
+ * The in-place half of py_object_binary_reuse, for a v which has no other
+ * references and for which py_object_binary_can_reuse holds. Returns v,
+ * which may have moved, or NULL if memory ran out, leaving v as it was and
+ * the caller's reference to it untouched.
+ */
+struct py_object* py_object_binary_update(
+		enum py_binary_op, struct py_object*, struct py_object*);
+
+/* w[key] = v; deletes w[key] given NULL */
 int py_assign_subscript(
 		struct py_object*, struct py_object*, struct py_object*);
 
+/* u[v:w] = x; deletes u[v:w] given NULL */
+int py_assign_slice(
+		struct py_object*, struct py_object*, struct py_object*,
+		struct py_object*);
+
 struct py_object* py_object_ind(struct py_object*, struct py_object*);
 
 /* return u[v:w] */
@@ -40,8 +64,9 @@ struct py_object* py_loop_subscript(struct py_object*, struct py_object*);
 
 struct py_object* py_object_get_attr(struct py_object*, const char*);
 
-/* v.name = u */
-int py_object_set_attr(struct py_object*, const char*, struct py_object*);
+/* v.name = u, with name a string */
+int py_object_set_attr(
+		struct py_object*, struct py_object*, struct py_object*);
 
 struct py_object* py_call_function(
 		struct py_env*, struct py_object*, struct py_object*);
@@ -49,6 +74,6 @@ struct py_object* py_call_function(
 struct py_object* py_cmp_outcome(
 		enum py_cmp_op, struct py_object*, struct py_object*);
 
-int py_import_from(struct py_object*, struct py_object*, const char*);
+int py_import_from(struct py_object*, struct py_object*, struct py_object*);
 
 #endif
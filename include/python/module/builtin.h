@@ -15,6 +15,7 @@ enum py_result py_builtin_init(struct py_env*);
 void py_builtin_done(void);
 
 struct py_object* py_builtin_get(const char*);
+struct py_object* py_builtin_get_key(struct py_object*);
 
 void py_errors_done(void);
 
@@ -0,0 +1,18 @@
+/*
+ * Copyright 1991 by Stichting Mathematisch Centrum
+ * See `LICENCE' for more information.
+ */
+
+/* String module interface */
+
+#ifndef PY_STROP_H
+#define PY_STROP_H
+
+#include <python/result.h>
+
+struct py_env;
+
+/* Registers the module `string' */
+enum py_result py_strop_init(struct py_env*);
+
+#endif
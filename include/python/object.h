@@ -9,6 +9,7 @@
 #define PY_OBJECT_H
 
 #include <python/std.h>
+#include <python/env.h>
 
 /*
  * Objects are structures allocated on the heap. Special rules apply to
@@ -62,6 +63,17 @@
 # define PY_REF_DEBUG
 #endif
 
+/*
+ * Without reference debugging, callers of py_object_incref and
+ * py_object_decref get the inline versions below -- they are used several
+ * times per instruction. Define PY_NO_REF_INLINE to call the out-of-line
+ * versions in object.c regardless; these are there in every build.
+ */
+#if !defined(PY_REF_DEBUG) && !defined(PY_REF_TRACE) && \
+	defined(PY_INLINE) && !defined(PY_NO_REF_INLINE)
+# define PY_REF_INLINE
+#endif
+
 enum py_type {
 	PY_TYPE_TYPE,
 	PY_TYPE_NONE,
@@ -84,12 +96,19 @@ enum py_type {
 	PY_TYPE_TUPLE,
 	PY_TYPE_LIST,
 	PY_TYPE_STRING,
+	PY_TYPE_ARRAY,
+	PY_TYPE_STRING_BUILDER,
 
 	PY_TYPE_DICT,
+	PY_TYPE_DICT_VIEW,
 
 	PY_TYPE_INT,
 	PY_TYPE_FLOAT,
 
+	/* Reserved for types defined by native modules (see py_type_new). */
+	PY_TYPE_USER,
+	PY_TYPE_USER_LAST = PY_TYPE_USER + 7,
+
 	PY_TYPE_MAX
 };
 
@@ -140,6 +159,30 @@ typedef struct py_object* (*py_cat_t)(struct py_object*, struct py_object*);
 typedef struct py_object* (*py_ind_t)(struct py_object*, unsigned);
 typedef struct py_object* (*py_slice_t)(struct py_object*, unsigned, unsigned);
 
+typedef struct py_object* (*py_unary_t)(struct py_object*);
+typedef struct py_object* (*py_binary_t)(struct py_object*, struct py_object*);
+typedef int (*py_truthy_t)(struct py_object*);
+typedef struct py_object* (*py_get_attr_t)(struct py_object*, const char*);
+typedef int (*py_set_attr_t)(
+		struct py_object*, struct py_object*, struct py_object*);
+typedef long (*py_hash_t)(struct py_object*);
+
+/*
+ * Arithmetic for numeric types. The binary methods are entered into
+ * py_binary_ops for two operands of the type itself; they may be entered
+ * for other operand types as well, in which case they must check what
+ * they're given.
+ */
+struct py_number_methods {
+	py_binary_t add;
+	py_binary_t sub;
+	py_binary_t mul;
+	py_binary_t div;
+	py_binary_t mod;
+
+	py_unary_t neg;
+};
+
 struct py_type_info {
 	unsigned size; /* For allocation */
 
@@ -150,11 +193,41 @@ struct py_type_info {
 	py_cat_t cat;
 	py_ind_t ind;
 	py_slice_t slice;
+
+	const struct py_number_methods* number;
+
+	py_truthy_t truthy; /* NULL means always true */
+	py_get_attr_t get_attr;
+	py_set_attr_t set_attr; /* Name as a string; given NULL, removes */
+	py_hash_t hash; /* NULL means unhashable; returns -1 for errors */
 };
 
 /* TODO: Python global state. */
 extern struct py_type_info py_types[PY_TYPE_MAX];
 
+/*
+ * Binary operators are dispatched on the types of both operands through
+ * py_binary_ops. py_types_register fills in each type's own number methods
+ * (and `cat' for addition) along with the mixed int/float cases; native
+ * modules can add more with py_binary_register. A NULL entry means the
+ * operation doesn't apply to those types.
+ */
+enum py_binary_op {
+	PY_BINARY_ADD,
+	PY_BINARY_SUB,
+	PY_BINARY_MUL,
+	PY_BINARY_DIV,
+	PY_BINARY_MOD,
+
+	PY_BINARY_MAX
+};
+
+/* TODO: Python global state. */
+extern py_binary_t py_binary_ops[PY_BINARY_MAX][PY_TYPE_MAX][PY_TYPE_MAX];
+
+void py_binary_register(
+		enum py_binary_op, enum py_type, enum py_type, py_binary_t);
+
 /* Generic operations on objects */
 
 /*
@@ -174,6 +247,10 @@ int py_object_cmp(const struct py_object*, const struct py_object*);
 
 int py_is_varobject(const void*);
 unsigned py_varobject_size(const void*);
+int py_varobject_truthy(struct py_object*);
+
+/* Sets a type error for objects without a hash method. */
+long py_object_hash(struct py_object*);
 
 /*
  * py_object_incref and py_object_decref are used to increment or decrement
@@ -207,16 +284,80 @@ unsigned py_varobject_size(const void*);
 extern long py_ref_total;
 #endif
 
+/*
+ * The `_nonnull' variants skip the NULL check, for references which are
+ * known to be there (constants, the current frame, PY_NONE...).
+ * py_object_dealloc is what py_object_decref does once the count reaches
+ * zero; don't call it otherwise.
+ */
+void py_object_dealloc(struct py_object*);
+
+#ifdef PY_REF_INLINE
+PY_INLINE void* py_object_incref_nonnull(void* p) {
+	((struct py_object*) p)->refcount++;
+
+	return p;
+}
+
+PY_INLINE void* py_object_decref_nonnull(void* p) {
+	if(--((struct py_object*) p)->refcount == 0) py_object_dealloc(p);
+
+	return p;
+}
+
+PY_INLINE void* py_object_incref(void* p) {
+	if(p) ((struct py_object*) p)->refcount++;
+
+	return p;
+}
+
+PY_INLINE void* py_object_decref(void* p) {
+	if(p && --((struct py_object*) p)->refcount == 0) py_object_dealloc(p);
+
+	return p;
+}
+#else
 void* py_object_incref(void*);
 void* py_object_decref(void*);
 
+# define py_object_incref_nonnull(p) py_object_incref(p)
+# define py_object_decref_nonnull(p) py_object_decref(p)
+#endif
+
 void* py_object_newref(void*);
 void py_object_unref(void*);
 
+/*
+ * py_object_release is py_object_decref for use in the deallocators of
+ * containers: an item whose reference count drops to zero is put on a
+ * queue of dead objects rather than deallocated recursively. The queue is
+ * emptied iteratively by the outermost py_object_decref, unless deferral
+ * has been switched on with py_object_set_deferred(1) -- in that case
+ * the queue is only emptied by py_object_drain, which the embedder should
+ * call regularly (e.g. once per frame). py_object_drain stops after
+ * `max' objects or `ticks' clock() ticks, whichever comes first (zero
+ * meaning no limit) and returns the number of objects still pending.
+ */
+void py_object_release(void*);
+void py_object_set_deferred(int);
+unsigned py_object_pending(void);
+unsigned py_object_drain(unsigned, clock_t);
+
 #ifdef PY_REF_TRACE
 void py_print_refs(FILE*);
 #endif
 
+/*
+ * Statistics kept by the dedicated allocators of small, short-lived objects
+ * (see `py_int_get_stats' and `py_float_get_stats').
+ */
+struct py_alloc_stats {
+	unsigned long blocks; /* Blocks requested from malloc() */
+	unsigned long allocs; /* Objects handed out */
+	unsigned long frees; /* Objects put back on the free list */
+	unsigned long free; /* Objects currently on the free list */
+};
+
 /*
  * py_none_object is an object of undefined type which can be used in contexts
  * where NULL (nil) is not suitable (since NULL often means 'error').
@@ -0,0 +1,94 @@
+/*
+ * Copyright 1991 by Stichting Mathematisch Centrum
+ * See `LICENCE' for more information.
+ */
+
+/* Array object interface */
+
+#ifndef PY_ARRAYOBJECT_H
+#define PY_ARRAYOBJECT_H
+
+#include <python/object.h>
+
+/*
+ * struct py_array is a mutable sequence of numbers of a single kind, held
+ * unboxed in one contiguous buffer. Storing an item converts an int or
+ * float object to the array's kind; loading one makes a new int or float
+ * object for it. The size is fixed when the array is made.
+ *
+ * py_array_new makes a zero-filled array, and py_array_from_seq converts a
+ * list, tuple or other array (truncating floats for an int array, which
+ * fails for those out of its range); py_array_to_list goes the other way.
+ * py_array_set returns -1 with a type error for values of the wrong type,
+ * or a runtime error for ints outside the range of an int array, and
+ * (like py_list_get) doesn't check the index.
+ */
+
+#if INT_MAX == 2147483647
+typedef int py_int32_t;
+#else
+typedef long py_int32_t;
+#endif
+
+enum py_array_kind {
+	PY_ARRAY_INT32, /* 'i' */
+	PY_ARRAY_FLOAT32, /* 'f' */
+	PY_ARRAY_FLOAT64, /* 'd' */
+
+	PY_ARRAY_MAX
+};
+
+struct py_array {
+	struct py_varobject ob;
+	enum py_array_kind kind;
+	void* data; /* ob.size items of the given kind */
+};
+
+#define PY_ARRAY_INT32_DATA(op) ((py_int32_t*) ((struct py_array*) (op))->data)
+#define PY_ARRAY_FLOAT32_DATA(op) ((float*) ((struct py_array*) (op))->data)
+#define PY_ARRAY_FLOAT64_DATA(op) ((double*) ((struct py_array*) (op))->data)
+
+struct py_object* py_array_new(enum py_array_kind, unsigned);
+struct py_object* py_array_from_seq(enum py_array_kind, struct py_object*);
+struct py_object* py_array_to_list(struct py_object*);
+
+/* The kind for a type code, or PY_ARRAY_MAX if there is no such kind */
+enum py_array_kind py_array_kind_for(char);
+unsigned py_array_item_size(enum py_array_kind);
+
+int py_array_set(struct py_object*, unsigned, struct py_object*);
+
+void py_array_dealloc(struct py_object*);
+int py_array_cmp(const struct py_object*, const struct py_object*);
+
+struct py_object* py_array_cat(struct py_object*, struct py_object*);
+struct py_object* py_array_ind(struct py_object*, unsigned);
+struct py_object* py_array_slice(struct py_object*, unsigned, unsigned);
+
+/*
+ * Arithmetic on arrays is done item by item, giving a new array of the
+ * same kind. The operands are two arrays of the same kind and size, or an
+ * array and an int or float (an int for int arrays) which is combined with
+ * every item. See arrayops.c.
+ */
+extern const struct py_number_methods py_array_number;
+
+enum py_array_reduction {
+	PY_ARRAY_REDUCE_SUM,
+	PY_ARRAY_REDUCE_MIN,
+	PY_ARRAY_REDUCE_MAX
+};
+
+/* These give an int for int arrays and a float otherwise. */
+struct py_object* py_array_reduce(
+		struct py_object*, enum py_array_reduction);
+struct py_object* py_array_dot(struct py_object*, struct py_object*);
+
+/*
+ * Apply a math function to every item, giving a float array (of floats
+ * for float32 arrays, else of doubles). Domain and range errors give NaNs
+ * and infinities rather than exceptions.
+ */
+struct py_object* py_array_map(struct py_object*, double (*)(double));
+
+#endif
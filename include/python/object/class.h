@@ -16,15 +16,26 @@
  * but currently it isn't. We'll see if we can fix that later, sigh...
  */
 
+/*
+ * Instances of a class mostly have the same attributes, so rather than
+ * each keeping a dictionary of its own, the class maps the names of
+ * instance attributes to slots (`keys') and an instance only holds an
+ * array of values indexed by slot. An instance which sets an attribute
+ * the class has no room left for falls back to a dictionary of its own.
+ */
+
 struct py_class {
 	struct py_object ob;
 	struct py_object* attr; /* A dictionary */
+	struct py_object* keys; /* Instance attribute names to slot numbers */
 };
 
 struct py_class_member {
 	struct py_object ob;
 	struct py_class* class; /* The class object */
-	struct py_object* attr; /* A dictionary */
+	struct py_object* attr; /* A dictionary, or NULL while using `values' */
+	struct py_object** values; /* Indexed by slot, NULL where unset */
+	unsigned nvalues;
 };
 
 struct py_class_method {
@@ -39,6 +50,8 @@ void py_class_dealloc(struct py_object*);
 
 struct py_object* py_class_member_new(struct py_object*);
 struct py_object* py_class_member_get_attr(struct py_object*, const char*);
+int py_class_member_set_attr(
+		struct py_object*, struct py_object*, struct py_object*);
 void py_class_member_dealloc(struct py_object*);
 
 struct py_object* py_class_method_new(struct py_object*, struct py_object*);
@@ -4,12 +4,25 @@
  */
 
 /*
- * Dictionary object type -- mapping from char * to object.
- * NB: the key is given as a char *, not as a struct py_string.
+ * Dictionary object type -- mapping from hashable objects to objects.
+ * Keys may be of any type with a hash method (see py_object_hash): strings,
+ * ints, floats and tuples of these. Keys of different types never compare
+ * equal.
+ * NB: for the plain functions the key is given as a char *, standing for a
+ * string, whereas the `_key' variants and py_dict_lookup_object take the
+ * key as an object. These use the hash cached in a string, so prefer them
+ * for keys which are looked up repeatedly (e.g. names from a code object).
  * These functions set errno for errors. Functions py_dict_remove() and
- * py_dict_insert() return nonzero for errors, py_dict_size() returns -1,
- * the others NULL. A successful call to py_dict_insert() calls py_object_incref()
- * for the inserted item.
+ * py_dict_insert() (and their `_key' variants) return nonzero for errors,
+ * the others NULL. A successful call to py_dict_insert() calls
+ * py_object_incref() for the inserted item -- and py_dict_insert_key() for
+ * the key too, whereas py_dict_insert() has to make a key object, so
+ * prefer the latter when the key is at hand as a string object.
+ * py_dict_size() is the number of items, and py_dict_get_key() gives the
+ * key of the i'th item in insertion order, or NULL if it isn't a string.
+ * To visit every item, start pos at 0 and call py_dict_next() until it
+ * returns zero; it hands out borrowed references. Items may be removed
+ * (but not inserted) while doing so.
  */
 
 #ifndef PY_DICTOBJECT_H
@@ -18,12 +31,12 @@
 #include <python/object.h>
 
 /*
- * Invariant for entries: when in use, value is not NULL and key is
- * not NULL and not dummy; when not in use, value is NULL and key
- * is either NULL or dummy. A dummy key value cannot be replaced by NULL,
- * since otherwise other keys may be lost.
+ * The items, in insertion order; the index table (see dict.c) holds
+ * positions in this array. A removed item leaves a hole whose key and value
+ * are NULL, until the table is next rebuilt.
  */
 struct py_dictentry {
+	long hash; /* Of key, when in use */
 	struct py_object* key;
 	struct py_object* value;
 };
@@ -31,24 +44,69 @@ struct py_dictentry {
 struct py_dict {
 	struct py_object ob;
 
-	unsigned fill;
-	unsigned used;
-	unsigned size;
+	unsigned used; /* Items */
+	unsigned nentries; /* Entries taken, holes included */
+	unsigned usable; /* Entries allocated */
+	unsigned mask; /* Index table size less one; the size is a power of two */
+	unsigned long version; /* Bumped when items are removed or moved */
 
-	struct py_dictentry* table;
+	struct py_dictentry* entries;
+	void* indices;
 };
 
 struct py_object* py_dict_new(void);
+/* With room for the given number of items without resizing */
+struct py_object* py_dict_new_size(unsigned);
+struct py_object* py_dict_copy(struct py_object*);
 
 struct py_object* py_dict_lookup(struct py_object*, const char*);
+struct py_object* py_dict_lookup_key(struct py_object*, struct py_object*);
+int py_dict_insert_key(
+		struct py_object*, struct py_object*, struct py_object*);
+int py_dict_remove_key(struct py_object*, struct py_object*);
 struct py_object* py_dict_lookup_object(struct py_object*, struct py_object*);
 int py_dict_assign(struct py_object*, struct py_object*, struct py_object*);
 int py_dict_insert(struct py_object*, const char*, struct py_object*);
 int py_dict_remove(struct py_object*, const char*);
+void py_dict_clear(struct py_object*);
+int py_dict_next(
+		struct py_object*, unsigned*, struct py_object**, struct py_object**);
 unsigned py_dict_size(struct py_object*);
 const char* py_dict_get_key(struct py_object*, unsigned);
+int py_dict_truthy(struct py_object*);
 void py_dict_dealloc(struct py_object*);
 
-void py_done_dict(void);
+/*
+ * Views give the keys, values or items ((key, value) tuples) of a dict in
+ * insertion order, without copying them out: they can be taken len() of,
+ * indexed and looped over, and always reflect the current contents of the
+ * dict. Indexing walks the dict's entries from a cursor left by the
+ * previous access, so a loop over a view is linear even when removals have
+ * left holes in the entries.
+ */
+enum py_dict_view_kind {
+	PY_DICT_VIEW_KEYS,
+	PY_DICT_VIEW_VALUES,
+	PY_DICT_VIEW_ITEMS
+};
+
+struct py_dict_view {
+	struct py_object ob;
+
+	struct py_dict* dict;
+	enum py_dict_view_kind kind;
+
+	/* Entries before pos hold index items, as of the dict's version. */
+	unsigned index;
+	unsigned pos;
+	unsigned long version;
+};
+
+struct py_object* py_dict_view_new(
+		struct py_object*, enum py_dict_view_kind);
+unsigned py_dict_view_size(struct py_object*);
+struct py_object* py_dict_view_ind(struct py_object*, unsigned);
+int py_dict_view_truthy(struct py_object*);
+void py_dict_view_dealloc(struct py_object*);
 
 #endif
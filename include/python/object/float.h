@@ -21,6 +21,17 @@ struct py_float {
 
 struct py_object* py_float_new(double);
 double py_float_get(const struct py_object*);
+void py_float_get_stats(struct py_alloc_stats*);
+
 int py_float_cmp(const struct py_object*, const struct py_object*);
+int py_float_truthy(struct py_object*);
+long py_float_hash(struct py_object*);
+void py_float_dealloc(struct py_object*);
+
+extern const struct py_number_methods py_float_number;
+
+/* As py_int_update, with w an int or float */
+void py_float_update(
+		enum py_binary_op, struct py_object*, const struct py_object*);
 
 #endif
@@ -45,10 +45,23 @@ struct py_int {
 
 struct py_object* py_int_new(py_value_t);
 py_value_t py_int_get(const struct py_object*);
+void py_int_get_stats(struct py_alloc_stats*);
 
 int py_int_cmp(const struct py_object*, const struct py_object*);
+int py_int_truthy(struct py_object*);
+long py_int_hash(struct py_object*);
 void py_int_dealloc(struct py_object*);
 
+extern const struct py_number_methods py_int_number;
+
+/*
+ * Store v op w, with w an int, in v itself. This is only for an int which
+ * nobody else refers to (see py_object_binary_reuse), and leaves checking
+ * for division by zero to the caller.
+ */
+void py_int_update(
+		enum py_binary_op, struct py_object*, const struct py_object*);
+
 /*
  * False and True are special intobjects used by Boolean expressions.
  * All values of type Boolean must point to either of these; but in
@@ -22,9 +22,15 @@
  * returned item's reference count.
  */
 
+/*
+ * The item array has room for `allocated' items, of which the first
+ * ob.size are in use. Growing the list over-allocates in proportion to its
+ * size, so that appending is amortised constant time.
+ */
 struct py_list {
 	struct py_varobject ob;
 	struct py_object** item;
+	unsigned allocated;
 };
 
 struct py_object* py_list_new(unsigned);
@@ -33,6 +39,27 @@ void py_list_set(struct py_object*, unsigned, struct py_object*);
 int py_list_insert(struct py_object*, unsigned, struct py_object*);
 int py_list_add(struct py_object*, struct py_object*);
 
+/*
+ * Bulk operations. py_list_set_slice replaces items low to high (clipped
+ * like a slice) with the items of a list or tuple, or removes them given
+ * NULL; py_list_extend appends the items of a list or tuple. Both move the
+ * remaining items over in one go and return -1 for errors.
+ * py_list_pop takes item i out of the list, handing over its reference,
+ * and py_list_index gives the index of the first item equal to the given
+ * object, or -1 if there is none.
+ */
+int py_list_set_slice(
+		struct py_object*, unsigned, unsigned, struct py_object*);
+int py_list_extend(struct py_object*, struct py_object*);
+struct py_object* py_list_pop(struct py_object*, unsigned);
+long py_list_index(const struct py_object*, const struct py_object*);
+
+/*
+ * Sort a list in place, stably. If keys isn't NULL it holds an object for
+ * each item to compare in its place. Returns -1 if out of memory.
+ */
+int py_list_sort(struct py_object*, struct py_object**);
+
 void py_list_dealloc(struct py_object*);
 int py_list_cmp(const struct py_object*, const struct py_object*);
 
@@ -29,6 +29,8 @@ struct py_object* py_module_new_methods(
 		struct py_env*, const char*, const struct py_methodlist*);
 
 struct py_object* py_module_get_attr(struct py_object*, const char*);
+int py_module_set_attr(
+		struct py_object*, struct py_object*, struct py_object*);
 void py_module_dealloc(struct py_object*);
 
 #endif
@@ -25,21 +25,91 @@
  * functions should be applied to nil objects.
  */
 
-/* NB The type is revealed here only because it is used in dictobject.c */
+/*
+ * NB The type is revealed here only because it is used in dictobject.c
+ *
+ * A long enough tail of a string, as made by a slice s[i:], may be a view:
+ * rather than holding its characters itself, it refers to those of base
+ * from offset on, which are zero-terminated all the same. The base of a
+ * view is never a view itself. Use py_string_get to get at the characters.
+ * The empty string and the strings of a single character are shared, so
+ * strings of size 0 or 1 made with characters given don't take memory.
+ *
+ * A string which isn't a view and which nobody else refers to may still
+ * be grown in place by py_string_extend (see py_object_binary_reuse); it
+ * over-allocates, so that `s = s + x' in a loop takes amortised linear
+ * time. This returns the string, which may have moved, or NULL if out of
+ * memory, in which case the string is as it was.
+ */
 
 struct py_string {
 	struct py_varobject ob;
+	unsigned offset; /* Into base->value, for a view */
+	long hash; /* -1 until first asked for by py_string_hash */
+	struct py_string* base; /* NULL unless a view */
+	unsigned allocated; /* Characters value has room for, if not a view */
 	char value[1]; /* TODO: Is this supposed to be sized? FAM? */
 };
 
 struct py_object* py_string_new_size(const char*, unsigned);
 struct py_object* py_string_new(const char*);
 const char* py_string_get(const struct py_object*);
+void py_string_dealloc(struct py_object*);
+
+/*
+ * Return a new reference to the interned string with the given contents,
+ * creating it if need be. Use these for identifiers.
+ */
+struct py_object* py_string_intern_size(const char*, unsigned);
+struct py_object* py_string_intern(const char*);
+void py_done_string(void);
+
+/*
+ * A string builder collects pieces of a string in a buffer which grows
+ * geometrically, so that appending is amortised linear in the size of the
+ * piece. The buffer is itself a string object in the making, which
+ * py_string_builder_finish hands out without copying, leaving the builder
+ * empty for reuse. py_string_builder_append returns -1 if out of memory.
+ * py_string_join joins the strings in a list or tuple with a separator,
+ * in a single allocation.
+ */
+struct py_string_builder {
+	struct py_object ob;
+	struct py_string* str; /* The string so far, or NULL; ob.size is used */
+	unsigned allocated; /* Characters str has room for */
+};
+
+struct py_object* py_string_builder_new(unsigned);
+int py_string_builder_append(struct py_object*, const char*, unsigned);
+struct py_object* py_string_builder_finish(struct py_object*);
+void py_string_builder_dealloc(struct py_object*);
+
+struct py_object* py_string_join(struct py_object*, struct py_object*);
 
 struct py_object* py_string_cat(struct py_object*, struct py_object*);
+struct py_object* py_string_extend(struct py_object*, struct py_object*);
 struct py_object* py_string_ind(struct py_object*, unsigned);
 struct py_object* py_string_slice(struct py_object*, unsigned, unsigned);
 
+/*
+ * The offset of the first occurrence of needle (the latter two arguments)
+ * in haystack (the former two), or -1 if there is none. An empty needle is
+ * found at offset 0.
+ */
+long py_string_search(const char*, unsigned, const char*, unsigned);
+
 int py_string_cmp(const struct py_object*, const struct py_object*);
+long py_string_hash(struct py_object*);
+long py_string_hash_size(const char*, unsigned);
+
+/*
+ * The string hash is 32-bit FNV-1a, built from these steps so that hot
+ * paths can hash while they scan. The result is finished by mapping -1,
+ * which means an error, to -2.
+ */
+#define PY_STRING_HASH_INIT (2166136261UL)
+#define PY_STRING_HASH_STEP(h, c) \
+		((((h) ^ (unsigned char) (c)) * 16777619UL) & 0xFFFFFFFFUL)
+#define PY_STRING_HASH_DONE(h) ((long) (h) == -1 ? -2 : (long) (h))
 
 #endif
@@ -32,9 +32,11 @@ struct py_tuple {
 struct py_object* py_tuple_new(unsigned);
 struct py_object* py_tuple_get(const struct py_object*, unsigned);
 void py_tuple_set(struct py_object*, unsigned, struct py_object*);
+void py_done_tuple(void);
 
 void py_tuple_dealloc(struct py_object*);
 int py_tuple_cmp(const struct py_object*, const struct py_object*);
+long py_tuple_hash(struct py_object*);
 
 struct py_object* py_tuple_cat(struct py_object*, struct py_object*);
 struct py_object* py_tuple_ind(struct py_object*, unsigned);
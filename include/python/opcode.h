@@ -33,7 +33,14 @@ enum py_opcode {
 	PY_OP_SLICE = 30,
 	/* Also uses 31-33 */
 
+	PY_OP_STORE_SLICE = 40,
+	/* Also uses 41-43 */
+
+	PY_OP_DELETE_SLICE = 50,
+	/* Also uses 51-53 */
+
 	PY_OP_STORE_SUBSCR = 60,
+	PY_OP_DELETE_SUBSCR = 61,
 
 	PY_OP_PRINT_EXPR = 70,
 
@@ -49,20 +56,23 @@ enum py_opcode {
 	PY_OP_HAVE_ARGUMENT = 90, /* Opcodes from here have an argument: */
 
 	PY_OP_STORE_NAME = 90, /* Index in name list */
+	PY_OP_DELETE_NAME = 91, /* "" */
 	PY_OP_UNPACK_TUPLE = 92, /* Number of tuple items */
 	PY_OP_UNPACK_LIST = 93, /* Number of list items */
 
 	PY_OP_STORE_ATTR = 95, /* Index in name list */
+	PY_OP_DELETE_ATTR = 96, /* "" */
 
 	PY_OP_LOAD_CONST = 100, /* Index in const list */
 	PY_OP_LOAD_NAME = 101, /* Index in name list */
 	PY_OP_BUILD_TUPLE = 102, /* Number of tuple items */
 	PY_OP_BUILD_LIST = 103, /* Number of list items */
-	PY_OP_BUILD_MAP = 104, /* Always zero for now */
+	PY_OP_BUILD_MAP = 104, /* Number of items to make room for */
 	PY_OP_LOAD_ATTR = 105, /* Index in name list */
 	PY_OP_COMPARE_OP = 106, /* Comparison operator */
 	PY_OP_IMPORT_NAME = 107, /* Index in name list */
 	PY_OP_IMPORT_FROM = 108, /* Index in name list */
+	PY_OP_BUILD_MAP_CONST = 109, /* Index in const list of a dict to copy */
 
 	PY_OP_JUMP_FORWARD = 110, /* Number of bytes to skip */
 	PY_OP_JUMP_IF_FALSE = 111, /* "" */
@@ -11,11 +11,26 @@
 #include <python/result.h>
 #include <python/object.h>
 
+/*
+ * Allocation hooks (see alloc.h). `user' is passed back to every hook and
+ * the sizes given to `resize' and `release' are those the block was last
+ * allocated with.
+ */
+struct py_allocator {
+	void* (*alloc)(void* user, size_t);
+	void* (*resize)(void* user, void*, size_t old, size_t size);
+	void (*release)(void* user, void*, size_t);
+	void* user;
+};
+
 /* Main interpreter environment. */
 struct py {
 	/* Type info table. */
 	struct py_type_info types[PY_TYPE_MAX];
 
+	/* Memory allocation hooks -- any left NULL use the C library. */
+	struct py_allocator allocator;
+
 	/* Module search path. Null terminated string buffer. */
 	char** path;
 
@@ -40,6 +55,19 @@ struct py_env {
 	 */
 	/* Modules dict. */
 	struct py_object* modules;
+
+	/* Bytes allocated while this environment was current, and not freed. */
+	size_t allocated;
+	/*
+	 * Hard limit on `allocated', or zero for none. Allocations which would
+	 * exceed it fail, raising py_memory_error. `py_env_new' sets this to
+	 * zero; set it afterwards to impose a limit.
+	 */
+	size_t limit;
+
+	/* For alloc.c: identifies the environment in block headers. */
+	unsigned long serial;
+	struct py_env* next;
 };
 
 enum py_result py_new(struct py*, const char*);
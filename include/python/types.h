@@ -10,4 +10,12 @@
 
 enum py_result py_types_register(struct py*);
 
+/*
+ * Give a native type one of the reserved PY_TYPE_USER slots, returning
+ * the new type or PY_TYPE_MAX when they're all taken. `dealloc' must be
+ * set. Its number methods are entered into py_binary_ops; mixed operand
+ * types go in with py_binary_register.
+ */
+enum py_type py_type_new(const struct py_type_info*);
+
 #endif
@@ -0,0 +1,234 @@
+/*
+ * Copyright 1991 by Stichting Mathematisch Centrum
+ * See `LICENCE' for more information.
+ */
+
+/* Memory allocation through the interpreter's allocation hooks */
+
+#include <python/std.h>
+#include <python/state.h>
+#include <python/alloc.h>
+
+/*
+ * Every block carries a small header recording its size, the interpreter
+ * whose hooks allocated it and the environment it was charged to, so that
+ * it goes back to the same hooks (along with its size, which pooled
+ * allocators tend to want) and is credited back to the same environment
+ * when it's freed. Environments are recorded by serial number rather than
+ * address, as blocks may outlive theirs; one which is gone (or was never
+ * attached) isn't found, and its blocks are freed without credit.
+ */
+union py_alloc_header {
+	struct {
+		size_t size;
+		struct py* py;
+		unsigned long env; /* Serial of the environment charged, or 0 */
+	} h;
+
+	/* Keep whatever follows the header suitably aligned. */
+	double d;
+	long l;
+	void* p;
+};
+
+#define PY_ALLOC_HEADER (sizeof(union py_alloc_header))
+
+/* TODO: Python global state. */
+static struct py_env* py_alloc_env = NULL;
+static struct py_env* py_alloc_envs = NULL; /* Attached environments */
+static unsigned long py_alloc_serial = 0;
+
+/* The C library as a set of hooks, for when nothing else is given. */
+
+static void* py_alloc_default(void* user, size_t size) {
+	(void) user;
+	return malloc(size);
+}
+
+static void* py_alloc_default_resize(
+		void* user, void* p, size_t old, size_t size) {
+
+	(void) user;
+	(void) old;
+	return realloc(p, size);
+}
+
+static void py_alloc_default_release(void* user, void* p, size_t size) {
+	(void) user;
+	(void) size;
+	free(p);
+}
+
+void py_allocator_default(struct py_allocator* a) {
+	if(!a->alloc) a->alloc = py_alloc_default;
+	if(!a->resize) a->resize = py_alloc_default_resize;
+	if(!a->release) a->release = py_alloc_default_release;
+}
+
+struct py_env* py_env_use(struct py_env* env) {
+	struct py_env* prev = py_alloc_env;
+
+	py_alloc_env = env;
+
+	return prev;
+}
+
+void py_alloc_attach(struct py_env* env) {
+	env->serial = ++py_alloc_serial;
+	env->next = py_alloc_envs;
+	py_alloc_envs = env;
+}
+
+void py_alloc_detach(struct py_env* env) {
+	struct py_env** pp;
+
+	for(pp = &py_alloc_envs; *pp; pp = &(*pp)->next) {
+		if(*pp == env) {
+			*pp = env->next;
+			break;
+		}
+	}
+
+	if(py_alloc_env == env) py_alloc_env = 0;
+}
+
+static unsigned long py_alloc_serial_of(struct py_env* env) {
+	return env ? env->serial : 0;
+}
+
+/* The attached environment with the given serial, if there still is one. */
+static struct py_env* py_alloc_find(unsigned long serial) {
+	struct py_env* env;
+
+	if(!serial) return 0;
+
+	if(py_alloc_env && py_alloc_env->serial == serial) return py_alloc_env;
+
+	for(env = py_alloc_envs; env; env = env->next) {
+		if(env->serial == serial) return env;
+	}
+
+	return 0;
+}
+
+/* Charge `size' more bytes to env, failing if that takes it over its limit */
+static int py_alloc_charge(struct py_env* env, size_t size) {
+	if(!env) return 0;
+
+	if(env->limit) {
+		if(size > env->limit || env->allocated > env->limit - size) return -1;
+	}
+
+	env->allocated += size;
+
+	return 0;
+}
+
+static void py_alloc_credit(struct py_env* env, size_t size) {
+	if(env) env->allocated -= size;
+}
+
+void* py_malloc(size_t size) {
+	struct py_env* env = py_alloc_env;
+	struct py* py = env ? env->py : 0;
+	union py_alloc_header* p;
+	size_t total = size + PY_ALLOC_HEADER;
+
+	if(total < size) return 0;
+
+	if(py_alloc_charge(env, size) == -1) return 0;
+
+	if(py) p = py->allocator.alloc(py->allocator.user, total);
+	else p = malloc(total);
+
+	if(!p) {
+		py_alloc_credit(env, size);
+		return 0;
+	}
+
+	p->h.size = size;
+	p->h.py = py;
+	p->h.env = py_alloc_serial_of(env);
+
+	return p + 1;
+}
+
+void* py_calloc(size_t count, size_t size) {
+	void* p;
+
+	if(size && count > (size_t) -1 / size) return 0;
+
+	if(!(p = py_malloc(count * size))) return 0;
+
+	memset(p, 0, count * size);
+
+	return p;
+}
+
+/*
+ * A block charged to the current environment is charged the difference in
+ * size; one charged elsewhere is moved over to the current environment.
+ */
+void* py_realloc(void* p, size_t size) {
+	union py_alloc_header* h;
+	struct py_env* env = py_alloc_env;
+	struct py* py;
+	size_t old, charge;
+	size_t total = size + PY_ALLOC_HEADER;
+	unsigned long owner;
+	int same;
+
+	if(!p) return py_malloc(size);
+
+	if(total < size) return 0;
+
+	h = (union py_alloc_header*) p - 1;
+	py = h->h.py;
+	old = h->h.size;
+	owner = h->h.env;
+
+	same = owner == py_alloc_serial_of(env);
+	if(same) charge = size > old ? size - old : 0;
+	else charge = size;
+
+	if(py_alloc_charge(env, charge) == -1) return 0;
+
+	if(py) {
+		struct py_allocator* a = &py->allocator;
+		h = a->resize(a->user, h, old + PY_ALLOC_HEADER, total);
+	}
+	else h = realloc(h, total);
+
+	if(!h) {
+		py_alloc_credit(env, charge);
+		return 0;
+	}
+
+	if(!same) {
+		py_alloc_credit(py_alloc_find(owner), old);
+		h->h.env = py_alloc_serial_of(env);
+	}
+	else if(size < old) py_alloc_credit(env, old - size);
+
+	h->h.size = size;
+
+	return h + 1;
+}
+
+void py_free(void* p) {
+	union py_alloc_header* h;
+	struct py* py;
+
+	if(!p) return;
+
+	h = (union py_alloc_header*) p - 1;
+	py = h->h.py;
+
+	py_alloc_credit(py_alloc_find(h->h.env), h->h.size);
+
+	if(py) {
+		struct py_allocator* a = &py->allocator;
+		a->release(a->user, h, h->h.size + PY_ALLOC_HEADER);
+	}
+	else free(h);
+}
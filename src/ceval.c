@@ -7,6 +7,7 @@
 
 #include <python/state.h>
 #include <python/std.h>
+#include <python/alloc.h>
 #include <python/env.h>
 #include <python/evalops.h>
 #include <python/import.h>
@@ -41,6 +42,45 @@ static const char* py_code_get_name(struct py_frame* f, unsigned i) {
 	return py_string_get(py_list_get(f->code->names, i));
 }
 
+/*
+ * py_object_binary_reuse for the operands of a BINARY_* instruction. In
+ * `name = name op w', the left operand v is also held by the local which
+ * is about to be rebound, so it can't be updated in place. If the next
+ * instruction stores to that very local, and v op w can only fail for want
+ * of memory, drop the local's reference to v first (binding None in its
+ * place) so that it can. Should memory run out after all, v is bound back
+ * to the local, leaving it as it was before the statement.
+ * This costs two more dictionary lookups, which only pay off when they
+ * save copying a string or list; ints and floats are cheaper made afresh.
+ */
+static struct py_object* py_binary_target(
+		struct py_frame* f, const py_byte_t* next, enum py_binary_op op,
+		struct py_object* v, struct py_object* w) {
+
+	struct py_object* name;
+	struct py_object* x;
+
+	if(v->refcount == 2 && next[0] == PY_OP_STORE_NAME &&
+			(v->type == PY_TYPE_STRING || v->type == PY_TYPE_LIST) &&
+			py_object_binary_can_reuse(op, v, w)) {
+
+		name = py_list_get(f->code->names, (next[2] << 8) + next[1]);
+
+		if(py_dict_lookup_key(f->locals, name) == v) {
+			py_dict_insert_key(f->locals, name, PY_NONE);
+
+			if(!(x = py_object_binary_update(op, v, w))) {
+				py_dict_insert_key(f->locals, name, v);
+				py_object_decref(v);
+			}
+
+			return x;
+		}
+	}
+
+	return py_object_binary_reuse(op, v, w);
+}
+
 /* Interpreter main loop */
 
 struct py_object* py_code_eval(
@@ -60,8 +100,10 @@ struct py_object* py_code_eval(
 	struct py_object* v; /* Temporary objects popped off stack */
 	struct py_object* w;
 	struct py_object* u;
+	struct py_object* t;
 
 	struct py_frame* f; /* Current frame */
+	struct py_env* prev_env; /* Environment current on entry */
 
 	struct py_object* retval = 0; /* Return value if why == PY_WHY_RETURN */
 	enum py_ceval_why why = PY_WHY_NOT; /* Reason for block stack unwind */
@@ -69,9 +111,12 @@ struct py_object* py_code_eval(
 
 	apro_stamp_start(APRO_CEVAL_CODE_EVAL_RISING);
 
+	prev_env = py_env_use(env);
+
 	/* TODO: Why are these constants the random defaults. */
 	if(!(f = py_frame_new(env->current, co, globals, locals, 50, 20))) {
 		py_error_set_nomem();
+		py_env_use(prev_env);
 		return 0;
 	}
 
@@ -143,10 +188,7 @@ struct py_object* py_code_eval(
 			case PY_OP_UNARY_NEGATIVE: {
 				v = *--stack_pointer;
 
-				if(!(*stack_pointer++ = py_object_neg(v))) {
-					py_error_set_evalop();
-					why = PY_WHY_EXCEPTION;
-				}
+				if(!(*stack_pointer++ = py_object_neg(v))) why = PY_WHY_EXCEPTION;
 
 				py_object_decref(v);
 
@@ -196,12 +238,9 @@ struct py_object* py_code_eval(
 				w = *--stack_pointer;
 				v = *--stack_pointer;
 
-				if(!(*stack_pointer++ = py_object_mul(v, w))) {
-					py_error_set_evalop();
-					why = PY_WHY_EXCEPTION;
-				}
+				x = py_binary_target(f, next, PY_BINARY_MUL, v, w);
+				if(!(*stack_pointer++ = x)) why = PY_WHY_EXCEPTION;
 
-				py_object_decref(v);
 				py_object_decref(w);
 
 				break;
@@ -211,12 +250,9 @@ struct py_object* py_code_eval(
 				w = *--stack_pointer;
 				v = *--stack_pointer;
 
-				if(!(*stack_pointer++ = py_object_div(v, w))) {
-					py_error_set_evalop();
-					why = PY_WHY_EXCEPTION;
-				}
+				x = py_binary_target(f, next, PY_BINARY_DIV, v, w);
+				if(!(*stack_pointer++ = x)) why = PY_WHY_EXCEPTION;
 
-				py_object_decref(v);
 				py_object_decref(w);
 
 				break;
@@ -226,12 +262,9 @@ struct py_object* py_code_eval(
 				w = *--stack_pointer;
 				v = *--stack_pointer;
 
-				if(!(*stack_pointer++ = py_object_mod(v, w))) {
-					py_error_set_evalop();
-					why = PY_WHY_EXCEPTION;
-				}
+				x = py_binary_target(f, next, PY_BINARY_MOD, v, w);
+				if(!(*stack_pointer++ = x)) why = PY_WHY_EXCEPTION;
 
-				py_object_decref(v);
 				py_object_decref(w);
 
 				break;
@@ -241,12 +274,9 @@ struct py_object* py_code_eval(
 				w = *--stack_pointer;
 				v = *--stack_pointer;
 
-				if(!(*stack_pointer++ = py_object_add(v, w))) {
-					py_error_set_badcall();
-					why = PY_WHY_EXCEPTION;
-				}
+				x = py_binary_target(f, next, PY_BINARY_ADD, v, w);
+				if(!(*stack_pointer++ = x)) why = PY_WHY_EXCEPTION;
 
-				py_object_decref(v);
 				py_object_decref(w);
 
 				break;
@@ -256,12 +286,9 @@ struct py_object* py_code_eval(
 				w = *--stack_pointer;
 				v = *--stack_pointer;
 
-				if(!(*stack_pointer++ = py_object_sub(v, w))) {
-					py_error_set_badcall();
-					why = PY_WHY_EXCEPTION;
-				}
+				x = py_binary_target(f, next, PY_BINARY_SUB, v, w);
+				if(!(*stack_pointer++ = x)) why = PY_WHY_EXCEPTION;
 
-				py_object_decref(v);
 				py_object_decref(w);
 
 				break;
@@ -272,7 +299,7 @@ struct py_object* py_code_eval(
 				v = *--stack_pointer;
 
 				if(!(*stack_pointer++ = py_object_ind(v, w))) {
-					py_error_set_evalop();
+					if(!py_error_occurred()) py_error_set_evalop();
 					why = PY_WHY_EXCEPTION;
 				}
 
@@ -324,13 +351,70 @@ struct py_object* py_code_eval(
 				break;
 			}
 
+			case PY_OP_STORE_SLICE + 0:; PY_FALLTHROUGH;
+			/* FALLTHROUGH */
+			case PY_OP_STORE_SLICE + 1:; PY_FALLTHROUGH;
+			/* FALLTHROUGH */
+			case PY_OP_STORE_SLICE + 2:; PY_FALLTHROUGH;
+			/* FALLTHROUGH */
+			case PY_OP_STORE_SLICE + 3:; PY_FALLTHROUGH;
+			/* FALLTHROUGH */
+			case PY_OP_DELETE_SLICE + 0:; PY_FALLTHROUGH;
+			/* FALLTHROUGH */
+			case PY_OP_DELETE_SLICE + 1:; PY_FALLTHROUGH;
+			/* FALLTHROUGH */
+			case PY_OP_DELETE_SLICE + 2:; PY_FALLTHROUGH;
+			/* FALLTHROUGH */
+			case PY_OP_DELETE_SLICE + 3: {
+				int delete = opcode >= PY_OP_DELETE_SLICE;
+				int k = opcode - (delete ? PY_OP_DELETE_SLICE : PY_OP_STORE_SLICE);
+
+				if(k & 2) w = *--stack_pointer;
+				else w = 0;
+
+				if(k & 1) v = *--stack_pointer;
+				else v = 0;
+
+				u = *--stack_pointer;
+
+				if(!delete) t = *--stack_pointer;
+				else t = 0;
+
+				if(py_assign_slice(u, v, w, t) == -1) {
+					if(!py_error_occurred()) py_error_set_evalop();
+					why = PY_WHY_EXCEPTION;
+				}
+
+				py_object_decref(t);
+				py_object_decref(u);
+				py_object_decref(v);
+				py_object_decref(w);
+
+				break;
+			}
+
+			case PY_OP_DELETE_SUBSCR: {
+				w = *--stack_pointer;
+				v = *--stack_pointer;
+
+				if(py_assign_subscript(v, w, 0) == -1) {
+					if(!py_error_occurred()) py_error_set_evalop();
+					why = PY_WHY_EXCEPTION;
+				}
+
+				py_object_decref(v);
+				py_object_decref(w);
+
+				break;
+			}
+
 			case PY_OP_STORE_SUBSCR: {
 				w = *--stack_pointer;
 				v = *--stack_pointer;
 				u = *--stack_pointer;
 
 				if(py_assign_subscript(v, w, u) == -1) {
-					py_error_set_evalop();
+					if(!py_error_occurred()) py_error_set_evalop();
 					why = PY_WHY_EXCEPTION;
 				}
 
@@ -353,7 +437,7 @@ struct py_object* py_code_eval(
 			}
 
 			case PY_OP_LOAD_LOCALS: {
-				*stack_pointer++ = py_object_incref(f->locals);
+				*stack_pointer++ = py_object_incref_nonnull(f->locals);
 				break;
 			}
 
@@ -414,7 +498,9 @@ struct py_object* py_code_eval(
 			case PY_OP_STORE_NAME: {
 				v = *--stack_pointer;
 
-				err = py_dict_insert(f->locals, py_code_get_name(f, oparg), v);
+				w = py_list_get(f->code->names, oparg);
+
+				err = py_dict_insert_key(f->locals, w, v);
 				if(err == -1) {
 					py_error_set_evalop();
 					why = PY_WHY_EXCEPTION;
@@ -425,6 +511,17 @@ struct py_object* py_code_eval(
 				break;
 			}
 
+			case PY_OP_DELETE_NAME: {
+				w = py_list_get(f->code->names, oparg);
+
+				if(py_dict_remove_key(f->locals, w) != 0) {
+					py_error_set_string(py_name_error, py_string_get(w));
+					why = PY_WHY_EXCEPTION;
+				}
+
+				break;
+			}
+
 			case PY_OP_UNPACK_TUPLE: {
 				v = *--stack_pointer;
 
@@ -480,9 +577,11 @@ struct py_object* py_code_eval(
 				v = *--stack_pointer;
 				u = *--stack_pointer;
 
-				err = py_object_set_attr(v, py_code_get_name(f, oparg), u);
+				w = py_list_get(f->code->names, oparg);
+
+				err = py_object_set_attr(v, w, u);
 				if(err == -1) {
-					py_error_set_evalop();
+					if(!py_error_occurred()) py_error_set_evalop();
 					why = PY_WHY_EXCEPTION;
 				}
 
@@ -492,22 +591,41 @@ struct py_object* py_code_eval(
 				break;
 			}
 
+			case PY_OP_DELETE_ATTR: {
+				v = *--stack_pointer;
+				w = py_list_get(f->code->names, oparg);
+
+				if(py_object_set_attr(v, w, 0) == -1) {
+					if(!py_error_occurred()) {
+						py_error_set_string(py_name_error, py_string_get(w));
+					}
+					why = PY_WHY_EXCEPTION;
+				}
+
+				py_object_decref(v);
+
+				break;
+			}
+
 			case PY_OP_LOAD_CONST: {
-				x = py_object_incref(py_list_get(f->code->consts, oparg));
+				x = py_object_incref_nonnull(py_list_get(f->code->consts, oparg));
 				*stack_pointer++ = x;
 				break;
 			}
 
 			case PY_OP_LOAD_NAME: {
-				const char* name = py_code_get_name(f, oparg);
+				w = py_list_get(f->code->names, oparg);
 
-				if(!(x = py_dict_lookup(f->locals, name))) {
-					if(!(x = py_dict_lookup(f->globals, name))) {
-						x = py_builtin_get(name);
+				if(!(x = py_dict_lookup_key(f->locals, w))) {
+					if(!(x = py_dict_lookup_key(f->globals, w))) {
+						x = py_builtin_get_key(w);
 					}
 				}
 
-				if(!x) py_error_set_string(py_name_error, name);
+				if(!x) {
+					py_error_set_string(py_name_error, py_string_get(w));
+					why = PY_WHY_EXCEPTION;
+				}
 
 				*stack_pointer++ = py_object_incref(x);
 
@@ -543,7 +661,7 @@ struct py_object* py_code_eval(
 			}
 
 			case PY_OP_BUILD_MAP: {
-				if(!(*stack_pointer++ = py_dict_new())) {
+				if(!(*stack_pointer++ = py_dict_new_size(oparg))) {
 					py_error_set_nomem();
 					why = PY_WHY_EXCEPTION;
 				}
@@ -551,11 +669,21 @@ struct py_object* py_code_eval(
 				break;
 			}
 
+			case PY_OP_BUILD_MAP_CONST: {
+				v = py_list_get(f->code->consts, oparg);
+
+				if(!(*stack_pointer++ = py_dict_copy(v))) {
+					why = PY_WHY_EXCEPTION;
+				}
+
+				break;
+			}
+
 			case PY_OP_LOAD_ATTR: {
 				v = *--stack_pointer;
 
 				x = py_object_get_attr(v, py_code_get_name(f, oparg));
-				*stack_pointer++ = x;
+				if(!(*stack_pointer++ = x)) why = PY_WHY_EXCEPTION;
 
 				py_object_decref(v);
 
@@ -567,7 +695,7 @@ struct py_object* py_code_eval(
 				v = *--stack_pointer;
 
 				if(!(*stack_pointer++ = py_cmp_outcome(oparg, v, w))) {
-					py_error_set_evalop();
+					if(!py_error_occurred()) py_error_set_evalop();
 					why = PY_WHY_EXCEPTION;
 				}
 
@@ -591,7 +719,9 @@ struct py_object* py_code_eval(
 			case PY_OP_IMPORT_FROM: {
 				v = stack_pointer[-1];
 
-				err = py_import_from(f->locals, v, py_code_get_name(f, oparg));
+				w = py_list_get(f->code->names, oparg);
+
+				err = py_import_from(f->locals, v, w);
 				if(err == -1) {
 					py_error_set_evalop();
 					why = PY_WHY_EXCEPTION;
@@ -632,7 +762,7 @@ struct py_object* py_code_eval(
 				w = *--stack_pointer; /* Loop index */
 				v = *--stack_pointer; /* Sequence struct py_object*/
 
-				if (!py_is_varobject(v)) {
+				if (!py_is_varobject(v) && v->type != PY_TYPE_DICT_VIEW) {
 					py_error_set_string(
 							py_type_error, "loop over non-sequence");
 
@@ -736,7 +866,9 @@ struct py_object* py_code_eval(
 
 	/* Restore previous frame and release the current one */
 	env->current = f->back;
-	py_object_decref(f);
+	py_object_decref_nonnull(f);
+
+	py_env_use(prev_env);
 
 	apro_stamp_end(APRO_CEVAL_CODE_EVAL_FALLING);
 
@@ -13,6 +13,7 @@
  */
 
 #include <python/std.h>
+#include <python/alloc.h>
 #include <python/env.h>
 #include <python/token.h>
 #include <python/graminit.h>
@@ -24,6 +25,7 @@
 #include <python/object/int.h>
 #include <python/object/float.h>
 #include <python/object/string.h>
+#include <python/object/dict.h>
 
 #define PY_CODE_CHUNK (1024)
 
@@ -40,15 +42,26 @@ struct py_compiler {
 
 	unsigned in_function; /* set when compiling a function */
 	unsigned nesting; /* counts nested loops */
+
+	/*
+	 * Counts errors, such as running out of memory, after which compiling
+	 * carries on (so that there's a single way out) but the code made is
+	 * thrown away. The error itself is set where it happens.
+	 */
+	unsigned errors;
 };
 
+/* Takes over code, which is freed if this fails */
 static struct py_code* py_code_new(
 		py_byte_t* code, struct py_object* consts,
 		struct py_object* names, const char* filename) {
 
 	struct py_code* co;
 
-	if(!(co = py_object_new(PY_TYPE_CODE))) return 0;
+	if(!(co = py_object_new(PY_TYPE_CODE))) {
+		py_free(code);
+		return 0;
+	}
 
 	co->code = code;
 	co->consts = py_object_incref(consts);
@@ -77,11 +90,13 @@ static int py_compiler_new(struct py_compiler* c, const char* filename) {
 	c->offset = 0;
 	c->in_function = 0;
 	c->nesting = 0;
+	c->errors = 0;
 	c->filename = filename;
 
 	return 1;
 }
 
+/* Doesn't free the code, which goes to the code object if all went well */
 static void py_compiler_delete(struct py_compiler* c) {
 	py_object_decref(c->consts);
 	py_object_decref(c->names);
@@ -89,11 +104,11 @@ static void py_compiler_delete(struct py_compiler* c) {
 
 static void py_compile_add_byte(struct py_compiler* c, py_byte_t byte) {
 	if(c->offset >= c->len) {
-		void* newptr = realloc(c->code, c->len + PY_CODE_CHUNK);
+		void* newptr = py_realloc(c->code, c->len + PY_CODE_CHUNK);
 		if(!newptr) {
-			free(c->code);
-			/* TODO: Better nomem handling */
-			abort();
+			py_error_set_nomem();
+			c->errors++;
+			return;
 		}
 
 		c->code = newptr;
@@ -135,6 +150,9 @@ static void py_compile_backpatch(struct py_compiler* c, unsigned anchor) {
 	unsigned prev;
 	int dist;
 
+	/* Anchors may be past the end of the code if it couldn't grow. */
+	if(c->errors) return;
+
 	for(;;) {
 		/* Make the JUMP instruction at anchor point to target */
 		prev = c->code[anchor] + (c->code[anchor + 1] << 8);
@@ -150,7 +168,9 @@ static void py_compile_backpatch(struct py_compiler* c, unsigned anchor) {
 }
 
 /* Handle constants and names uniformly */
-static unsigned py_compile_add(struct py_object* list, struct py_object* v) {
+static unsigned py_compile_add(
+		struct py_compiler* c, struct py_object* list, struct py_object* v) {
+
 	unsigned n = py_varobject_size(list);
 	unsigned i;
 
@@ -160,8 +180,10 @@ static unsigned py_compile_add(struct py_object* list, struct py_object* v) {
 		if(py_object_cmp(v, w) == 0) return i - 1;
 	}
 
-	/* TODO: Better EH. */
-	if(py_list_add(list, v) == -1) py_fatal("oom");
+	if(py_list_add(list, v) == -1) {
+		c->errors++;
+		return 0;
+	}
 
 	return n;
 }
@@ -169,7 +191,7 @@ static unsigned py_compile_add(struct py_object* list, struct py_object* v) {
 static unsigned py_compile_add_const(
 		struct py_compiler* c, struct py_object* v) {
 
-	return py_compile_add(c->consts, v);
+	return py_compile_add(c, c->consts, v);
 }
 
 static void py_compile_add_op_name(
@@ -185,12 +207,12 @@ static void py_compile_add_op_name(
 		name = n->str;
 	}
 
-	if(!(v = py_string_new(name))) {
-		/* TODO: Proper EH. */
-		abort();
+	if(!(v = py_string_intern(name))) {
+		c->errors++;
+		i = 0;
 	}
 	else {
-		i = py_compile_add(c->names, v);
+		i = py_compile_add(c, c->names, v);
 		py_object_decref(v);
 	}
 
@@ -223,9 +245,11 @@ static struct py_object* py_compile_parse_string(const char* s) {
 	struct py_object* retval;
 
 	for(i = 1; s[i] != '\''; ++i) {
-		/* TODO: Leaky realloc. */
-		void* newptr = realloc(buf, ++len);
-		if(!newptr) return py_error_set_nomem();
+		void* newptr = py_realloc(buf, ++len);
+		if(!newptr) {
+			py_free(buf);
+			return py_error_set_nomem();
+		}
 		buf = newptr;
 
 		buf[len - 1] = s[i];
@@ -249,6 +273,7 @@ static struct py_object* py_compile_parse_string(const char* s) {
 	}
 
 	if(!(retval = py_string_new_size(buf, len))) py_error_set_nomem();
+	py_free(buf);
 
 	return retval;
 }
@@ -268,6 +293,111 @@ static void py_compile_list_constructor(
 	py_compile_add_op_arg(c, PY_OP_BUILD_LIST, len);
 }
 
+/* The number or string an expression consists of alone, or NULL. */
+static struct py_node* py_compile_literal(struct py_node* n) {
+	/* Look through the chain of single-child nodes down to the atom. */
+	while(n->type >= PY_NONTERMINAL && n->count == 1) n = &n->children[0];
+
+	if(n->type == PY_NUMBER || n->type == PY_STRING) return n;
+
+	return 0;
+}
+
+static struct py_object* py_compile_parse_literal(
+		struct py_compiler* c, struct py_node* n) {
+
+	struct py_object* v;
+
+	n = py_compile_literal(n);
+
+	if(n->type == PY_NUMBER) v = py_compile_parse_number(n->str);
+	else v = py_compile_parse_string(n->str);
+
+	if(!v) c->errors++;
+
+	return v;
+}
+
+/*
+ * If every key and value in a dict display is a literal, build the dict
+ * here once so that the display just copies it.
+ */
+static struct py_object* py_compile_const_dict(
+		struct py_compiler* c, struct py_node* n, unsigned len) {
+
+	struct py_object* d;
+	unsigned i;
+
+	for(i = 0; i < n->count; i += 2) {
+		if(!py_compile_literal(&n->children[i])) return 0;
+	}
+
+	if(!(d = py_dict_new_size(len))) {
+		c->errors++;
+		return 0;
+	}
+
+	for(i = 0; i < n->count; i += 4) {
+		struct py_object* k = py_compile_parse_literal(c, &n->children[i]);
+		struct py_object* v = py_compile_parse_literal(c, &n->children[i + 2]);
+		int err = !k || !v || py_dict_insert_key(d, k, v) != 0;
+
+		py_object_decref(k);
+		py_object_decref(v);
+
+		if(err) {
+			if(k && v) c->errors++;
+			py_object_decref(d);
+			return 0;
+		}
+	}
+
+	return d;
+}
+
+static void py_compile_dict_constructor(
+		struct py_compiler* c, struct py_node* n) {
+
+	struct py_object* d;
+	unsigned len, i;
+
+	PY_REQ(n, PY_GRAMMAR_DICT_MAKER);
+
+	/*
+	 * PY_GRAMMAR_DICT_MAKER: PY_GRAMMAR_TEST ':' PY_GRAMMAR_TEST
+	 * (',' PY_GRAMMAR_TEST ':' PY_GRAMMAR_TEST)* [',']
+	 */
+	len = (n->count + 1) / 4;
+
+	if((d = py_compile_const_dict(c, n, len))) {
+		i = py_compile_add_const(c, d);
+		py_object_decref(d);
+
+		py_compile_add_op_arg(c, PY_OP_BUILD_MAP_CONST, i);
+
+		return;
+	}
+
+	/*
+	 * Each item is stored as d[k] = v with the dict left on the stack:
+	 * 			d               PY_OP_DUP_TOP
+	 * 			d, d            <v>
+	 * 			d, d, v         PY_OP_ROT_TWO
+	 * 			d, v, d         <k>
+	 * 			d, v, d, k      PY_OP_STORE_SUBSCR
+	 * 			d
+	 */
+	py_compile_add_op_arg(c, PY_OP_BUILD_MAP, len);
+
+	for(i = 0; i < n->count; i += 4) {
+		py_compile_add_byte(c, PY_OP_DUP_TOP);
+		py_compile_node(c, &n->children[i + 2]);
+		py_compile_add_byte(c, PY_OP_ROT_TWO);
+		py_compile_node(c, &n->children[i]);
+		py_compile_add_byte(c, PY_OP_STORE_SUBSCR);
+	}
+}
+
 static void py_compile_atom(struct py_compiler* c, struct py_node* n) {
 	struct py_node* ch;
 	struct py_object* v;
@@ -296,15 +426,18 @@ static void py_compile_atom(struct py_compiler* c, struct py_node* n) {
 		}
 
 		case PY_LBRACE: {
-			py_compile_add_op_arg(c, PY_OP_BUILD_MAP, 0);
+			if(n->children[1].type == PY_RBRACE) {
+				py_compile_add_op_arg(c, PY_OP_BUILD_MAP, 0);
+			}
+			else py_compile_dict_constructor(c, &n->children[1]);
 
 			break;
 		}
 
 		case PY_NUMBER: {
 			if((v = py_compile_parse_number(ch->str)) == NULL) {
-				/* TODO: Proper EH. */
-				abort();
+				c->errors++;
+				i = 0;
 			}
 			else {
 				i = py_compile_add_const(c, v);
@@ -318,8 +451,8 @@ static void py_compile_atom(struct py_compiler* c, struct py_node* n) {
 
 		case PY_STRING: {
 			if((v = py_compile_parse_string(ch->str)) == NULL) {
-				/* TODO: Proper EH. */
-				abort();
+				c->errors++;
+				i = 0;
 			}
 			else {
 				i = py_compile_add_const(c, v);
@@ -347,6 +480,32 @@ static void py_compile_atom(struct py_compiler* c, struct py_node* n) {
 	}
 }
 
+/*
+ * Emit the bounds of a slice, [PY_GRAMMAR_EXPRESSION] ':'
+ * [PY_GRAMMAR_EXPRESSION], followed by op plus 1 if the lower bound is
+ * present and plus 2 if the upper one is.
+ */
+static void py_compile_slice(
+		struct py_compiler* c, struct py_node* n, enum py_opcode op) {
+
+	if(n->count == 1) py_compile_add_byte(c, op);
+	else if(n->count == 2) {
+		if(n->children[0].type != PY_COLON) {
+			py_compile_node(c, &n->children[0]);
+			py_compile_add_byte(c, op + 1);
+		}
+		else {
+			py_compile_node(c, &n->children[1]);
+			py_compile_add_byte(c, op + 2);
+		}
+	}
+	else {
+		py_compile_node(c, &n->children[0]);
+		py_compile_node(c, &n->children[2]);
+		py_compile_add_byte(c, op + 3);
+	}
+}
+
 static void py_compile_apply_subscript(struct py_compiler* c, struct py_node* n) {
 	PY_REQ(n, PY_GRAMMAR_SUBSCRIPT);
 
@@ -355,25 +514,7 @@ static void py_compile_apply_subscript(struct py_compiler* c, struct py_node* n)
 		py_compile_node(c, &n->children[0]);
 		py_compile_add_byte(c, PY_OP_BINARY_SUBSCR);
 	}
-	else {
-		/* It's a slice: [PY_GRAMMAR_EXPRESSION] ':' [PY_GRAMMAR_EXPRESSION] */
-		if(n->count == 1) py_compile_add_byte(c, PY_OP_SLICE);
-		else if(n->count == 2) {
-			if(n->children[0].type != PY_COLON) {
-				py_compile_node(c, &n->children[0]);
-				py_compile_add_byte(c, PY_OP_SLICE + 1);
-			}
-			else {
-				py_compile_node(c, &n->children[1]);
-				py_compile_add_byte(c, PY_OP_SLICE + 2);
-			}
-		}
-		else {
-			py_compile_node(c, &n->children[0]);
-			py_compile_node(c, &n->children[2]);
-			py_compile_add_byte(c, PY_OP_SLICE + 3);
-		}
-	}
+	else py_compile_slice(c, n, PY_OP_SLICE);
 }
 
 static void py_compile_select_member(struct py_compiler* c, struct py_node* n) {
@@ -706,10 +847,13 @@ static void py_compile_list(struct py_compiler* c, struct py_node* n) {
 }
 
 
-/* Begin of assignment compilation */
+/*
+ * Begin of assignment compilation. The same code compiles the targets of
+ * a 'del' statement, with assigning zero.
+ */
 
 static void py_compile_assign_trailer(
-		struct py_compiler* c, struct py_node* n) {
+		struct py_compiler* c, struct py_node* n, int assigning) {
 
 	PY_REQ(n, PY_GRAMMAR_TRAILER);
 
@@ -722,7 +866,9 @@ static void py_compile_assign_trailer(
 		}
 
 		case PY_DOT: { /* '.' PY_NAME */
-			py_compile_add_op_name(c, PY_OP_STORE_ATTR, &n->children[1]);
+			py_compile_add_op_name(
+					c, assigning ? PY_OP_STORE_ATTR : PY_OP_DELETE_ATTR,
+					&n->children[1]);
 
 			break;
 		}
@@ -732,8 +878,15 @@ static void py_compile_assign_trailer(
 
 			PY_REQ(n, PY_GRAMMAR_SUBSCRIPT); /* PY_GRAMMAR_SUBSCRIPT: PY_GRAMMAR_EXPRESSION | [PY_GRAMMAR_EXPRESSION] ':' [PY_GRAMMAR_EXPRESSION] */
 
-			py_compile_node(c, &n->children[0]);
-			py_compile_add_byte(c, PY_OP_STORE_SUBSCR);
+			if(n->count == 1 && n->children[0].type != PY_COLON) {
+				py_compile_node(c, &n->children[0]);
+				py_compile_add_byte(
+						c, assigning ? PY_OP_STORE_SUBSCR : PY_OP_DELETE_SUBSCR);
+			}
+			else {
+				py_compile_slice(
+						c, n, assigning ? PY_OP_STORE_SLICE : PY_OP_DELETE_SLICE);
+			}
 
 			break;
 		}
@@ -748,38 +901,48 @@ static void py_compile_assign_trailer(
 }
 
 static void py_compile_assign(
-		struct py_compiler* c, struct py_node* n);
+		struct py_compiler* c, struct py_node* n, int assigning);
 
 static void py_compile_assign_tuple(
-		struct py_compiler* c, struct py_node* n) {
+		struct py_compiler* c, struct py_node* n, int assigning) {
 
 	unsigned i;
 
 	if(n->type != PY_GRAMMAR_TEST_LIST) PY_REQ(n, PY_GRAMMAR_EXPRESSION_LIST);
 
-	py_compile_add_op_arg(c, PY_OP_UNPACK_TUPLE, (n->count + 1) / 2);
+	if(assigning) {
+		py_compile_add_op_arg(c, PY_OP_UNPACK_TUPLE, (n->count + 1) / 2);
+	}
 
-	for(i = 0; i < n->count; i += 2) py_compile_assign(c, &n->children[i]);
+	for(i = 0; i < n->count; i += 2) {
+		py_compile_assign(c, &n->children[i], assigning);
+	}
 }
 
 static void py_compile_assign_list(
-		struct py_compiler* c, struct py_node* n) {
+		struct py_compiler* c, struct py_node* n, int assigning) {
 
 	unsigned i;
-	py_compile_add_op_arg(c, PY_OP_UNPACK_LIST, (n->count + 1) / 2);
 
-	for(i = 0; i < n->count; i += 2) py_compile_assign(c, &n->children[i]);
+	if(assigning) {
+		py_compile_add_op_arg(c, PY_OP_UNPACK_LIST, (n->count + 1) / 2);
+	}
+
+	for(i = 0; i < n->count; i += 2) {
+		py_compile_assign(c, &n->children[i], assigning);
+	}
 }
 
 static void py_compile_assign_name(
-		struct py_compiler* c, struct py_node* n) {
+		struct py_compiler* c, struct py_node* n, int assigning) {
 
 	PY_REQ(n, PY_NAME);
-	py_compile_add_op_name(c, PY_OP_STORE_NAME, n);
+	py_compile_add_op_name(
+			c, assigning ? PY_OP_STORE_NAME : PY_OP_DELETE_NAME, n);
 }
 
 static void py_compile_assign(
-		struct py_compiler* c, struct py_node* n) {
+		struct py_compiler* c, struct py_node* n, int assigning) {
 
 	/* Loop to avoid trivial recursion */
 	for(;;) {
@@ -788,7 +951,7 @@ static void py_compile_assign(
 			/* FALLTHROUGH */
 			case PY_GRAMMAR_TEST_LIST: {
 				if(n->count > 1) {
-					py_compile_assign_tuple(c, n);
+					py_compile_assign_tuple(c, n, assigning);
 					return;
 				}
 
@@ -870,7 +1033,7 @@ static void py_compile_assign(
 					} /* NB i is still alive */
 
 					py_compile_assign_trailer(
-							c, &n->children[i]);
+							c, &n->children[i], assigning);
 
 					return;
 				}
@@ -905,13 +1068,14 @@ static void py_compile_assign(
 							abort();
 						}
 
-						py_compile_assign_list(c, n);
+						py_compile_assign_list(c, n, assigning);
 
 						return;
 					}
 
 					case PY_NAME: {
-						py_compile_assign_name(c, &n->children[0]);
+						py_compile_assign_name(
+								c, &n->children[0], assigning);
 
 						return;
 					}
@@ -952,11 +1116,20 @@ static void py_compile_expression_stmt(
 		unsigned i;
 		for(i = 0; i < n->count - 3; i += 2) {
 			if(i + 2 < n->count - 3) py_compile_add_byte(c, PY_OP_DUP_TOP);
-			py_compile_assign(c, &n->children[i]);
+			py_compile_assign(c, &n->children[i], 1);
 		}
 	}
 }
 
+static void py_compile_del_statement(
+		struct py_compiler* c, struct py_node* n) {
+
+	/* 'del' PY_GRAMMAR_EXPRESSION_LIST PY_NEWLINE */
+	PY_REQ(n, PY_GRAMMAR_DEL_STATEMENT);
+
+	py_compile_assign(c, &n->children[1], 0);
+}
+
 static void py_compile_return_statement(
 		struct py_compiler* c, struct py_node* n) {
 
@@ -1095,20 +1268,18 @@ static void py_compile_for_statement(
 	py_compile_add_forward_reference(c, PY_OP_SETUP_LOOP, &break_anchor);
 	py_compile_node(c, &n->children[3]);
 
-	v = py_int_new(0);
-	if(v == NULL) {
-		/* TODO: Proper EH. */
-		abort();
+	if(!(v = py_int_new(0))) c->errors++;
+	else {
+		py_compile_add_op_arg(
+				c, PY_OP_LOAD_CONST, py_compile_add_const(c, v));
+		py_object_decref(v);
 	}
 
-	py_compile_add_op_arg(c, PY_OP_LOAD_CONST, py_compile_add_const(c, v));
-	py_object_decref(v);
-
 	begin = c->offset;
 
 	py_compile_add_op_arg(c, PY_OP_SET_LINENO, n->lineno);
 	py_compile_add_forward_reference(c, PY_OP_FOR_LOOP, &anchor);
-	py_compile_assign(c, &n->children[1]);
+	py_compile_assign(c, &n->children[1], 1);
 
 	c->nesting++;
 	py_compile_node(c, &n->children[5]);
@@ -1266,7 +1437,7 @@ static void py_compile_try_statement(
 
 			py_compile_add_byte(c, PY_OP_POP_TOP);
 
-			if(ch->count > 3) py_compile_assign(c, &ch->children[3]);
+			if(ch->count > 3) py_compile_assign(c, &ch->children[3], 1);
 			else py_compile_add_byte(c, PY_OP_POP_TOP);
 
 			py_compile_add_byte(c, PY_OP_POP_TOP);
@@ -1314,10 +1485,7 @@ static void py_compile_function_definition(
 	PY_REQ(n, PY_GRAMMAR_FUNCTION_DEFINITION);
 
 	v = (struct py_object*) py_compile(n, c->filename);
-	if(v == NULL) {
-		/* TODO: Proper EH. */
-		abort();
-	}
+	if(v == NULL) c->errors++;
 	else {
 		py_compile_add_op_arg(c, PY_OP_LOAD_CONST, py_compile_add_const(c, v));
 		py_compile_add_byte(c, PY_OP_BUILD_FUNCTION);
@@ -1347,10 +1515,7 @@ static void py_compile_class_definition(
 			c, PY_OP_LOAD_CONST, py_compile_add_const(c, PY_NONE));
 
 	v = (struct py_object*) py_compile(n, c->filename);
-	if(v == NULL) {
-		/* TODO: Proper EH. */
-		abort();
-	}
+	if(v == NULL) c->errors++;
 	else {
 		py_compile_add_op_arg(c, PY_OP_LOAD_CONST, py_compile_add_const(c, v));
 		py_compile_add_byte(c, PY_OP_BUILD_FUNCTION);
@@ -1403,6 +1568,12 @@ static void py_compile_node(struct py_compiler* c, struct py_node* n) {
 			break;
 		}
 
+		case PY_GRAMMAR_DEL_STATEMENT: {
+			py_compile_del_statement(c, n);
+
+			break;
+		}
+
 		case PY_GRAMMAR_BREAK_STATEMENT: {
 			if(c->nesting == 0) {
 				py_error_set_string(py_type_error, "'break' outside loop");
@@ -1667,8 +1838,18 @@ struct py_code* py_compile(struct py_node* n, const char* filename) {
 
 	compile_node(&sc, n);
 
-	newptr = realloc(sc.code, sc.offset);
-	if(!newptr) return NULL; /* TODO: Free dead compiler. */
+	if(sc.errors) {
+		py_free(sc.code);
+		py_compiler_delete(&sc);
+		return 0;
+	}
+
+	if(!(newptr = py_realloc(sc.code, sc.offset))) {
+		py_free(sc.code);
+		py_compiler_delete(&sc);
+		py_error_set_nomem();
+		return 0;
+	}
 	sc.code = newptr;
 	sc.len = sc.offset;
 
@@ -1681,8 +1862,10 @@ struct py_code* py_compile(struct py_node* n, const char* filename) {
 void py_code_dealloc(struct py_object* op) {
 	struct py_code* co = (struct py_code*) op;
 
-	free(co->code);
+	py_free(co->code);
 	py_object_decref(co->consts);
 	py_object_decref(co->names);
 	py_object_decref(co->filename);
+
+	py_free(op);
 }
@@ -6,6 +6,7 @@
 #include <python/evalops.h>
 #include <python/env.h>
 #include <python/ceval.h>
+#include <python/errors.h>
 
 #include <python/object/int.h>
 #include <python/object/func.h>
@@ -15,18 +16,19 @@
 #include <python/object/module.h>
 #include <python/object/string.h>
 #include <python/object/list.h>
+#include <python/object/array.h>
 #include <python/object/class.h>
 
 /* Test a value used as condition, e.g., in a for or if statement */
 int py_object_truthy(struct py_object* v) {
-	if(v->type == PY_TYPE_INT) return py_int_get(v) != 0;
-	else if(v->type == PY_TYPE_FLOAT) return py_float_get(v) != 0.0;
-	else if(py_is_varobject(v)) return py_varobject_size(v) != 0;
-	else if(v->type == PY_TYPE_DICT) return ((struct py_dict*) v)->used != 0;
-	else if(v == PY_NONE) return 0;
-
-	/* All other objects are 'true' */
-	return 1;
+	py_truthy_t truthy;
+
+	if(v == PY_NONE) return 0;
+
+	/* All other objects without a method are 'true' */
+	if(!(truthy = py_types[v->type].truthy)) return 1;
+
+	return truthy(v);
 }
 
 struct py_object* py_object_not(struct py_object* v) {
@@ -34,71 +36,90 @@ struct py_object* py_object_not(struct py_object* v) {
 }
 
 struct py_object* py_object_neg(struct py_object* v) {
-	if(v->type == PY_TYPE_INT) return py_int_new(-py_int_get(v));
-	else if(v->type == PY_TYPE_FLOAT) return py_float_new(-py_float_get(v));
+	const struct py_number_methods* number = py_types[v->type].number;
 
-	return 0;
+	if(!number || !number->neg) {
+		py_error_set_string(py_type_error, "bad operand type for unary -");
+		return 0;
+	}
+
+	return number->neg(v);
 }
 
-struct py_object* py_object_add(struct py_object* v, struct py_object* w) {
-	py_cat_t cat;
+struct py_object* py_object_binary(
+		enum py_binary_op op, struct py_object* v, struct py_object* w) {
 
-	if(v->type == PY_TYPE_INT && w->type == PY_TYPE_INT) {
-		return py_int_new(py_int_get(v) + py_int_get(w));
-	}
-	else if(v->type == PY_TYPE_FLOAT && w->type == PY_TYPE_FLOAT) {
-		return py_float_new(py_float_get(v) + py_float_get(w));
-	}
-	else if((cat = py_types[v->type].cat)) {
-		return cat(v, w);
+	py_binary_t f = py_binary_ops[op][v->type][w->type];
+
+	if(!f) {
+		py_error_set_string(py_type_error, "bad operand types for operator");
+		return 0;
 	}
 
-	return 0;
+	return f(v, w);
 }
 
-struct py_object* py_object_sub(struct py_object* v, struct py_object* w) {
-	if(v->type == PY_TYPE_INT && w->type == PY_TYPE_INT) {
-		return py_int_new(py_int_get(v) - py_int_get(w));
-	}
-	else if(v->type == PY_TYPE_FLOAT && w->type == PY_TYPE_FLOAT) {
-		return py_float_new(py_float_get(v) - py_float_get(w));
-	}
+int py_object_binary_can_reuse(
+		enum py_binary_op op, struct py_object* v, struct py_object* w) {
 
-	return 0;
-}
+	switch(v->type) {
+		default: return 0;
 
-struct py_object* py_object_mul(struct py_object* v, struct py_object* w) {
-	if(v->type == PY_TYPE_INT && w->type == PY_TYPE_INT) {
-		return py_int_new(py_int_get(v) * py_int_get(w));
-	}
-	else if(v->type == PY_TYPE_FLOAT && w->type == PY_TYPE_FLOAT) {
-		return py_float_new(py_float_get(v) * py_float_get(w));
-	}
+		case PY_TYPE_STRING: {
+			if(op != PY_BINARY_ADD || w->type != PY_TYPE_STRING) return 0;
 
-	return 0;
-}
+			return !((struct py_string*) v)->base;
+		}
 
+		case PY_TYPE_LIST: {
+			return op == PY_BINARY_ADD && w->type == PY_TYPE_LIST;
+		}
 
-struct py_object* py_object_div(struct py_object* v, struct py_object* w) {
-	if(v->type == PY_TYPE_INT && w->type == PY_TYPE_INT) {
-		return py_int_new(py_int_get(v) / py_int_get(w));
-	}
-	else if(v->type == PY_TYPE_FLOAT && w->type == PY_TYPE_FLOAT) {
-		return py_float_new(py_float_get(v) / py_float_get(w));
-	}
+		case PY_TYPE_INT: {
+			if(w->type != PY_TYPE_INT) return 0;
 
-	return 0;
+			if(op == PY_BINARY_DIV || op == PY_BINARY_MOD) {
+				return py_int_get(w) != 0;
+			}
+
+			return 1;
+		}
+
+		case PY_TYPE_FLOAT: {
+			return w->type == PY_TYPE_FLOAT || w->type == PY_TYPE_INT;
+		}
+	}
 }
 
-struct py_object* py_object_mod(struct py_object* v, struct py_object* w) {
-	if(v->type == PY_TYPE_INT && w->type == PY_TYPE_INT) {
-		return py_int_new(py_int_get(v) % py_int_get(w));
+struct py_object* py_object_binary_update(
+		enum py_binary_op op, struct py_object* v, struct py_object* w) {
+
+	switch(v->type) {
+		default: return 0;
+
+		case PY_TYPE_STRING: return py_string_extend(v, w);
+
+		case PY_TYPE_LIST: return py_list_extend(v, w) == -1 ? 0 : v;
+
+		case PY_TYPE_INT: py_int_update(op, v, w); return v;
+		case PY_TYPE_FLOAT: py_float_update(op, v, w); return v;
 	}
-	else if(v->type == PY_TYPE_FLOAT && w->type == PY_TYPE_FLOAT) {
-		return py_float_new(fmod(py_float_get(v), py_float_get(w)));
+}
+
+struct py_object* py_object_binary_reuse(
+		enum py_binary_op op, struct py_object* v, struct py_object* w) {
+
+	struct py_object* x;
+
+	if(v->refcount == 1 && py_object_binary_can_reuse(op, v, w)) {
+		if(!(x = py_object_binary_update(op, v, w))) py_object_decref(v);
+		return x;
 	}
 
-	return 0;
+	x = py_object_binary(op, v, w);
+	py_object_decref(v);
+
+	return x;
 }
 
 int py_assign_subscript(
@@ -114,14 +135,33 @@ int py_assign_subscript(
 			return -1;
 		}
 
+		if(!value) {
+			py_object_decref(py_list_pop(op, i));
+			return 0;
+		}
+
 		py_object_decref(lp->item[i]);
 		lp->item[i] = py_object_incref(value);
 
 		return 0;
 	}
-	else if(op->type == PY_TYPE_DICT) {
-		if(key->type != PY_TYPE_STRING) return -1;
+	else if(op->type == PY_TYPE_ARRAY) {
+		unsigned i;
 
+		if(key->type != PY_TYPE_INT) return -1;
+
+		if((i = (unsigned) py_int_get(key)) >= py_varobject_size(op)) {
+			return -1;
+		}
+
+		if(!value) {
+			py_error_set_string(py_type_error, "can't delete array items");
+			return -1;
+		}
+
+		return py_array_set(op, i, value);
+	}
+	else if(op->type == PY_TYPE_DICT) {
 		return py_dict_assign(op, key, value);
 	}
 
@@ -132,9 +172,18 @@ struct py_object* py_object_ind(struct py_object* v, struct py_object* w) {
 	py_ind_t ind;
 
 	if((ind = py_types[v->type].ind)) {
+		unsigned i;
+
 		if(w->type != PY_TYPE_INT) return 0;
 
-		return ind(v, (unsigned) py_int_get(w));
+		/* The ind methods of sequences leave the index to us. */
+		i = (unsigned) py_int_get(w);
+		if(py_is_varobject(v) && i >= py_varobject_size(v)) {
+			py_error_set_string(py_runtime_error, "index out of range");
+			return 0;
+		}
+
+		return ind(v, i);
 	}
 	else if(v->type == PY_TYPE_DICT) return py_dict_lookup_object(v, w);
 
@@ -158,6 +207,26 @@ struct py_object* py_apply_slice(
 	return slice(u, low, high);
 }
 
+int py_assign_slice(
+		struct py_object* u, struct py_object* v, struct py_object* w,
+		struct py_object* x) {
+
+	unsigned low, high;
+
+	if(u->type != PY_TYPE_LIST) {
+		py_error_set_string(py_type_error, "assign to slice of non-list");
+		return -1;
+	}
+
+	low = 0;
+	high = py_varobject_size(u);
+
+	if(py_slice_index(v, &low) != 0) return -1;
+	if(py_slice_index(w, &high) != 0) return -1;
+
+	return py_list_set_slice(u, low, high, x);
+}
+
 int py_slice_index(struct py_object* v, unsigned* pi) {
 	if(!v) return 0;
 
@@ -170,7 +239,10 @@ int py_slice_index(struct py_object* v, unsigned* pi) {
 
 struct py_object* py_loop_subscript(struct py_object* v, struct py_object* w) {
 	unsigned i = (unsigned) py_int_get(w);
-	unsigned n = py_varobject_size(v);
+	unsigned n;
+
+	if(v->type == PY_TYPE_DICT_VIEW) n = py_dict_view_size(v);
+	else n = py_varobject_size(v);
 
 	if(i >= n) return 0; /* End of loop */
 
@@ -178,28 +250,32 @@ struct py_object* py_loop_subscript(struct py_object* v, struct py_object* w) {
 }
 
 struct py_object* py_object_get_attr(struct py_object* v, const char* name) {
-	switch(v->type) {
-		default: return 0;
+	py_get_attr_t get_attr = py_types[v->type].get_attr;
+	struct py_object* x;
+
+	if(!get_attr) {
+		py_error_set_string(py_type_error, "object has no attributes");
+		return 0;
+	}
 
-		case PY_TYPE_CLASS_MEMBER: return py_class_member_get_attr(v, name);
-		case PY_TYPE_CLASS: return py_class_get_attr(v, name);
-		case PY_TYPE_MODULE: return py_module_get_attr(v, name);
+	if(!(x = get_attr(v, name)) && !py_error_occurred()) {
+		py_error_set_string(py_name_error, name);
 	}
+
+	return x;
 }
 
 int py_object_set_attr(
-		struct py_object* v, const char* name, struct py_object* w) {
+		struct py_object* v, struct py_object* name, struct py_object* w) {
 
-	struct py_object* attr;
+	py_set_attr_t set_attr = py_types[v->type].set_attr;
 
-	if(v->type == PY_TYPE_CLASS_MEMBER) {
-		attr = ((struct py_class_member*) v)->attr;
+	if(!set_attr) {
+		py_error_set_string(py_type_error, "can't set attributes of object");
+		return -1;
 	}
-	else if(v->type == PY_TYPE_MODULE) attr = ((struct py_module*) v)->attr;
-	else return -1;
 
-	if(!w) return py_dict_remove(attr, name);
-	else return py_dict_insert(attr, name, w);
+	return set_attr(v, name, w);
 }
 
 /*
@@ -283,35 +359,64 @@ static int py_cmp_exception(struct py_object* err, struct py_object* v) {
 }
 
 static int py_cmp_member(struct py_object* v, struct py_object* w) {
-	struct py_object* x;
+	struct py_object** items;
 	unsigned i, n;
-	int cmp;
 
-	/* Special case for char in string */
+	/* For strings, `in' looks for a substring. */
 	if(w->type == PY_TYPE_STRING) {
-		const char* s;
-		char c;
+		long found;
 
-		if(v->type != PY_TYPE_STRING || py_varobject_size(v) != 1) return -1;
-
-		c = py_string_get(v)[0];
-		s = py_string_get(w);
+		if(v->type != PY_TYPE_STRING) {
+			py_error_set_string(
+					py_type_error, "'in <string>' needs a string on the left");
+			return -1;
+		}
 
-		while(s < s + py_varobject_size(w)) if(c == *s++) return 1;
+		found = py_string_search(
+				py_string_get(w), py_varobject_size(w),
+				py_string_get(v), py_varobject_size(v));
 
-		return 0;
+		return found != -1;
 	}
 
 	if(!py_is_varobject(w)) return -1;
 
 	n = py_varobject_size(w);
 
+	/*
+	 * The items of lists and tuples are looked at in place: most hits are
+	 * the very same object (names, small ints, ...), and the rest can only
+	 * be equal if they are of the same type.
+	 */
+	if(w->type == PY_TYPE_LIST) items = ((struct py_list*) w)->item;
+	else if(w->type == PY_TYPE_TUPLE) items = ((struct py_tuple*) w)->item;
+	else {
+		for(i = 0; i < n; i++) {
+			struct py_object* x = py_types[w->type].ind(w, i);
+			int cmp;
+
+			if(!x) return -1;
+
+			cmp = py_object_cmp(v, x);
+			py_object_decref(x);
+
+			if(cmp == 0) return 1;
+		}
+
+		return 0;
+	}
+
+	if(!py_types[v->type].cmp) {
+		for(i = 0; i < n; i++) if(items[i] == v) return 1;
+
+		return 0;
+	}
+
 	for(i = 0; i < n; i++) {
-		x = py_types[w->type].ind(w, i);
-		cmp = py_object_cmp(v, x);
-		py_object_decref(x);
+		struct py_object* x = items[i];
 
-		if(cmp == 0) return 1;
+		if(x == v) return 1;
+		if(x->type == v->type && !py_types[v->type].cmp(v, x)) return 1;
 	}
 
 	return 0;
@@ -371,28 +476,26 @@ struct py_object* py_cmp_outcome(
 }
 
 int py_import_from(
-		struct py_object* locals, struct py_object* v, const char* name) {
+		struct py_object* locals, struct py_object* v, struct py_object* name) {
 
 	struct py_object* x;
 	struct py_object* w = ((struct py_module*) v)->attr;
 
-	if(name[0] == '*') {
-		unsigned i;
-
-		for(i = 0; i < py_dict_size(w); i++) {
-			name = py_dict_get_key(w, i);
-
-			if(!name || name[0] == '_') continue;
+	if(py_string_get(name)[0] == '*') {
+		unsigned pos = 0;
+		struct py_object* k;
 
-			if(!(x = py_dict_lookup(w, name))) return -1;
+		while(py_dict_next(w, &pos, &k, &x)) {
+			if(k->type != PY_TYPE_STRING) continue;
+			if(py_string_get(k)[0] == '_') continue;
 
-			if(py_dict_insert(locals, name, x) != 0) return -1;
+			if(py_dict_insert_key(locals, k, x) != 0) return -1;
 		}
 
 		return 0;
 	}
 
-	if(!(x = py_dict_lookup(w, name))) return -1;
+	if(!(x = py_dict_lookup_key(w, name))) return -1;
 
-	return py_dict_insert(locals, name, x);
+	return py_dict_insert_key(locals, name, x);
 }
@@ -109,19 +109,10 @@ struct py_object* py_import_module(struct py_env* env, const char* name) {
 	return m;
 }
 
-/* TODO: Shouldn't this be in dictobject? */
-static void py_dict_clear(struct py_object* d) {
-	unsigned i;
-
-	for(i = 0; i < py_dict_size(d); ++i) {
-		const char* k = py_dict_get_key(d, i);
-		if(k) (void) py_dict_remove(d, k);
-	}
-}
-
 void py_import_done(struct py_env* env) {
 	if(env->modules != NULL) {
-		unsigned i;
+		unsigned pos = 0;
+		struct py_object* m;
 
 		/*
 		 * Explicitly erase all py_modules; this is the safest way to get rid
@@ -129,23 +120,11 @@ void py_import_done(struct py_env* env) {
 		 */
 
 		/* TODO: Make this more robust. */
-		for(i = 0; i < py_dict_size(env->modules); ++i) {
-			const char* k = py_dict_get_key(env->modules, i);
-
-			/*
-			 * TODO: Are all these checks neccesary when iterating through a
-			 * 		 Dict?
-			 */
-			if(k) {
-				struct py_object* m = py_dict_lookup(env->modules, k);
-
-				if(m) {
-					struct py_object* d = ((struct py_module*) m)->attr;
-
-					/* TODO: Can a module have a null attr dict? */
-					if(d) py_dict_clear(d);
-				}
-			}
+		while(py_dict_next(env->modules, &pos, 0, &m)) {
+			struct py_object* d = ((struct py_module*) m)->attr;
+
+			/* TODO: Can a module have a null attr dict? */
+			if(d) py_dict_clear(d);
 		}
 
 		py_dict_clear(env->modules);
@@ -9,6 +9,8 @@
 #include <python/node.h>
 #include <python/import.h>
 #include <python/errors.h>
+#include <python/evalops.h>
+#include <python/alloc.h>
 
 #include <python/module/builtin.h>
 
@@ -17,6 +19,7 @@
 #include <python/object/string.h>
 #include <python/object/module.h>
 #include <python/object/list.h>
+#include <python/object/array.h>
 #include <python/object/dict.h>
 #include <python/object/tuple.h>
 
@@ -83,6 +86,7 @@ static struct py_object* py_builtin_len(
 
 	if(py_is_varobject(args)) len = py_varobject_size(args);
 	else if(args->type == PY_TYPE_DICT) len = ((struct py_dict*) args)->used;
+	else if(args->type == PY_TYPE_DICT_VIEW) len = py_dict_view_size(args);
 	else {
 		py_error_set_string(py_type_error, "len() of unsized object");
 		return NULL;
@@ -177,20 +181,93 @@ static struct py_object* py_builtin_append(
 	(void) env;
 	(void) self;
 
-	if(!args || args->type != PY_TYPE_TUPLE ||
-		(lp = py_tuple_get(args, 0))->type != PY_TYPE_LIST) {
-
+	if(!args || args->type != PY_TYPE_TUPLE || py_varobject_size(args) != 2) {
 		py_error_set_badarg();
 		return 0;
 	}
 
+	lp = py_tuple_get(args, 0);
 	op = py_tuple_get(args, 1);
 
+	if(lp->type == PY_TYPE_STRING_BUILDER) {
+		if(op->type != PY_TYPE_STRING) {
+			py_error_set_badarg();
+			return 0;
+		}
+
+		if(py_string_builder_append(
+				lp, py_string_get(op), py_varobject_size(op)) == -1) {
+
+			return 0;
+		}
+
+		return py_object_incref(PY_NONE);
+	}
+
+	if(lp->type != PY_TYPE_LIST) {
+		py_error_set_badarg();
+		return 0;
+	}
+
 	if(py_list_add(lp, op) == -1) return py_error_set_nomem();
 
 	return py_object_incref(PY_NONE);
 }
 
+/* join(sep, seq): the strings in a list or tuple, separated by sep */
+static struct py_object* py_builtin_join(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* sep;
+
+	(void) env;
+	(void) self;
+
+	if(!args || args->type != PY_TYPE_TUPLE || py_varobject_size(args) != 2 ||
+			(sep = py_tuple_get(args, 0))->type != PY_TYPE_STRING) {
+
+		py_error_set_badarg();
+		return 0;
+	}
+
+	return py_string_join(sep, py_tuple_get(args, 1));
+}
+
+/*
+ * builder() or builder(size): a string builder, with room for size
+ * characters to start with. append(b, s) adds to it and finish(b) gives
+ * the string built.
+ */
+static struct py_object* py_builtin_builder(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	(void) env;
+	(void) self;
+
+	if(!args) return py_string_builder_new(0);
+
+	if(args->type != PY_TYPE_INT || py_int_get(args) < 0) {
+		py_error_set_badarg();
+		return 0;
+	}
+
+	return py_string_builder_new((unsigned) py_int_get(args));
+}
+
+static struct py_object* py_builtin_finish(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	(void) env;
+	(void) self;
+
+	if(!args || args->type != PY_TYPE_STRING_BUILDER) {
+		py_error_set_badarg();
+		return 0;
+	}
+
+	return py_string_builder_finish(args);
+}
+
 static struct py_object* py_builtin_insert(
 		struct py_env* env, struct py_object* self, struct py_object* args) {
 
@@ -218,6 +295,223 @@ static struct py_object* py_builtin_insert(
 	return py_object_incref(PY_NONE);
 }
 
+/* extend(list, seq): appends the items of a list or tuple */
+static struct py_object* py_builtin_extend(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* lp;
+
+	(void) env;
+	(void) self;
+
+	if(!args || args->type != PY_TYPE_TUPLE || py_varobject_size(args) != 2 ||
+			(lp = py_tuple_get(args, 0))->type != PY_TYPE_LIST) {
+
+		py_error_set_badarg();
+		return 0;
+	}
+
+	if(py_list_extend(lp, py_tuple_get(args, 1)) == -1) return 0;
+
+	return py_object_incref(PY_NONE);
+}
+
+/* pop(list) or pop(list, i): removes and returns the last or i'th item */
+static struct py_object* py_builtin_pop(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* lp = args;
+	struct py_object* ind;
+	unsigned i;
+
+	(void) env;
+	(void) self;
+
+	if(args && args->type == PY_TYPE_TUPLE) {
+		if(py_varobject_size(args) != 2 ||
+				(lp = py_tuple_get(args, 0))->type != PY_TYPE_LIST ||
+				(ind = py_tuple_get(args, 1))->type != PY_TYPE_INT) {
+
+			py_error_set_badarg();
+			return 0;
+		}
+
+		i = (unsigned) py_int_get(ind);
+	}
+	else if(!lp || lp->type != PY_TYPE_LIST) {
+		py_error_set_badarg();
+		return 0;
+	}
+	else i = py_varobject_size(lp) - 1;
+
+	return py_list_pop(lp, i);
+}
+
+/* index(list, x): the index of the first item equal to x */
+static struct py_object* py_builtin_index(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* lp;
+	long i;
+
+	(void) env;
+	(void) self;
+
+	if(!args || args->type != PY_TYPE_TUPLE || py_varobject_size(args) != 2 ||
+			(lp = py_tuple_get(args, 0))->type != PY_TYPE_LIST) {
+
+		py_error_set_badarg();
+		return 0;
+	}
+
+	if((i = py_list_index(lp, py_tuple_get(args, 1))) == -1) {
+		py_error_set_string(py_runtime_error, "item not in list");
+		return 0;
+	}
+
+	return py_int_new(i);
+}
+
+/*
+ * sort(list) or sort(list, key): sorts the list in place. A key function
+ * is called once per item, and the items are ordered by the results.
+ */
+static struct py_object* py_builtin_sort(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* lp = args;
+	struct py_object* func = 0;
+	struct py_object** keys = 0;
+	unsigned i, n;
+	int err;
+
+	(void) self;
+
+	if(args && args->type == PY_TYPE_TUPLE && py_varobject_size(args) == 2) {
+		lp = py_tuple_get(args, 0);
+		func = py_tuple_get(args, 1);
+	}
+
+	if(!lp || lp->type != PY_TYPE_LIST) {
+		py_error_set_badarg();
+		return 0;
+	}
+
+	n = py_varobject_size(lp);
+
+	if(func && n) {
+		if(!(keys = py_calloc(n, sizeof(struct py_object*)))) {
+			return py_error_set_nomem();
+		}
+
+		/*
+		 * The key function may change the list under us, so the size is
+		 * checked afresh each time round and the item is held on to for
+		 * the duration of the call.
+		 */
+		err = 0;
+		for(i = 0; i < n && i < py_varobject_size(lp); i++) {
+			struct py_object* item = py_object_incref(py_list_get(lp, i));
+
+			keys[i] = py_call_function(env, func, item);
+			py_object_decref(item);
+
+			if(!keys[i]) {
+				err = 1;
+				break;
+			}
+		}
+
+		/* The key function may have failed or changed the list. */
+		if(i < n || py_varobject_size(lp) != n) {
+			if(!err) {
+				py_error_set_string(
+						py_runtime_error, "list changed size during sort");
+			}
+			else if(!py_error_occurred()) py_error_set_evalop();
+
+			while(i--) py_object_decref(keys[i]);
+			py_free(keys);
+
+			return 0;
+		}
+	}
+
+	err = py_list_sort(lp, keys);
+
+	if(keys) {
+		for(i = 0; i < n; i++) py_object_decref(keys[i]);
+		py_free(keys);
+	}
+
+	if(err) return 0;
+
+	return py_object_incref(PY_NONE);
+}
+
+/*
+ * array(code, init): makes an array of the kind given by the type code
+ * 'i', 'f' or 'd', either zero-filled to the length given or converted
+ * from a list, tuple or array.
+ */
+static struct py_object* py_builtin_array(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* code;
+	struct py_object* init;
+	enum py_array_kind kind;
+
+	(void) env;
+	(void) self;
+
+	if(!args || args->type != PY_TYPE_TUPLE || py_varobject_size(args) != 2 ||
+			(code = py_tuple_get(args, 0))->type != PY_TYPE_STRING ||
+			py_varobject_size(code) != 1) {
+
+		py_error_set_badarg();
+		return 0;
+	}
+
+	if((kind = py_array_kind_for(py_string_get(code)[0])) == PY_ARRAY_MAX) {
+		py_error_set_string(py_runtime_error, "bad array type code");
+		return 0;
+	}
+
+	init = py_tuple_get(args, 1);
+
+	if(init->type == PY_TYPE_INT) {
+		if(py_int_get(init) < 0) {
+			py_error_set_badarg();
+			return 0;
+		}
+
+		/* Beyond UINT_MAX, unless it comes back the same as an unsigned. */
+		if((py_value_t) (unsigned) py_int_get(init) != py_int_get(init)) {
+			py_error_set_string(py_runtime_error, "array size out of range");
+			return 0;
+		}
+
+		return py_array_new(kind, (unsigned) py_int_get(init));
+	}
+
+	return py_array_from_seq(kind, init);
+}
+
+/* tolist(array): a list of the items of an array */
+static struct py_object* py_builtin_tolist(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	(void) env;
+	(void) self;
+
+	if(!args || args->type != PY_TYPE_ARRAY) {
+		py_error_set_badarg();
+		return 0;
+	}
+
+	return py_array_to_list(args);
+}
+
 static struct py_object* py_builtin_pass(
 		struct py_env* env, struct py_object* self, struct py_object* args) {
 
@@ -251,6 +545,44 @@ static struct py_object* py_builtin_notv(
 	return py_object_incref(retval);
 }
 
+static struct py_object* py_builtin_view(
+		struct py_object* args, enum py_dict_view_kind kind) {
+
+	if(!args || args->type != PY_TYPE_DICT) {
+		py_error_set_badarg();
+		return 0;
+	}
+
+	return py_dict_view_new(args, kind);
+}
+
+static struct py_object* py_builtin_keys(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	(void) env;
+	(void) self;
+
+	return py_builtin_view(args, PY_DICT_VIEW_KEYS);
+}
+
+static struct py_object* py_builtin_values(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	(void) env;
+	(void) self;
+
+	return py_builtin_view(args, PY_DICT_VIEW_VALUES);
+}
+
+static struct py_object* py_builtin_items(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	(void) env;
+	(void) self;
+
+	return py_builtin_view(args, PY_DICT_VIEW_ITEMS);
+}
+
 /* TODO: Python global state. */
 static struct py_methodlist py_builtin_methods[] = {
 		{ "float", py_builtin_float },
@@ -258,9 +590,21 @@ static struct py_methodlist py_builtin_methods[] = {
 		{ "len", py_builtin_len },
 		{ "range", py_builtin_range },
 		{ "append", py_builtin_append },
+		{ "join", py_builtin_join },
+		{ "builder", py_builtin_builder },
+		{ "finish", py_builtin_finish },
 		{ "insert", py_builtin_insert },
+		{ "extend", py_builtin_extend },
+		{ "pop", py_builtin_pop },
+		{ "index", py_builtin_index },
+		{ "sort", py_builtin_sort },
+		{ "array", py_builtin_array },
+		{ "tolist", py_builtin_tolist },
 		{ "pass", py_builtin_pass },
 		{ "notv", py_builtin_notv },
+		{ "keys", py_builtin_keys },
+		{ "values", py_builtin_values },
+		{ "items", py_builtin_items },
 		{ NULL, NULL } };
 
 /* TODO: Python global state. */
@@ -270,6 +614,10 @@ struct py_object* py_builtin_get(const char* name) {
 	return py_dict_lookup(py_builtin_dict, name);
 }
 
+struct py_object* py_builtin_get_key(struct py_object* name) {
+	return py_dict_lookup_key(py_builtin_dict, name);
+}
+
 static struct py_object* py_exception_new(
 		const char* name, const char* message) {
 
@@ -13,6 +13,7 @@
 #include <python/object/float.h>
 #include <python/object/int.h>
 #include <python/object/tuple.h>
+#include <python/object/array.h>
 
 typedef double (*py_math1_t)(double);
 typedef double (*py_math2_t)(double, double);
@@ -49,6 +50,9 @@ static struct py_object* py_math1_impl(
 
 	double x;
 
+	/* Arrays are done a whole at a time. */
+	if(args && args->type == PY_TYPE_ARRAY) return py_array_map(args, func);
+
 	if(!py_arg_double(args, &x)) return NULL;
 
 	/* TODO: Better EH. */
@@ -113,6 +117,58 @@ PY_MATH2(atan2)
 PY_MATH2(fmod)
 PY_MATH2(pow)
 
+static struct py_object* py_math_reduce(
+		struct py_object* args, enum py_array_reduction r) {
+
+	if(!args || args->type != PY_TYPE_ARRAY) {
+		py_error_set_badarg();
+		return 0;
+	}
+
+	return py_array_reduce(args, r);
+}
+
+static struct py_object* py_math_sum(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+	(void) env;
+	(void) self;
+	return py_math_reduce(args, PY_ARRAY_REDUCE_SUM);
+}
+
+static struct py_object* py_math_min(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+	(void) env;
+	(void) self;
+	return py_math_reduce(args, PY_ARRAY_REDUCE_MIN);
+}
+
+static struct py_object* py_math_max(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+	(void) env;
+	(void) self;
+	return py_math_reduce(args, PY_ARRAY_REDUCE_MAX);
+}
+
+static struct py_object* py_math_dot(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* a;
+	struct py_object* b;
+
+	(void) env;
+	(void) self;
+
+	if(!args || args->type != PY_TYPE_TUPLE || py_varobject_size(args) != 2 ||
+		(a = py_tuple_get(args, 0))->type != PY_TYPE_ARRAY ||
+		(b = py_tuple_get(args, 1))->type != PY_TYPE_ARRAY) {
+
+		py_error_set_badarg();
+		return 0;
+	}
+
+	return py_array_dot(a, b);
+}
+
 static struct py_object* py_math_bitlist_op(
 		struct py_object* args, py_math_val2_t func) {
 
@@ -249,6 +305,10 @@ enum py_result py_math_init(struct py_env* env) {
 			py_(shl),
 			py_(shr),
 			py_(randf),
+			py_(sum),
+			py_(min),
+			py_(max),
+			py_(dot),
 			{ NULL, NULL } /* sentinel */
 	};
 #undef py_
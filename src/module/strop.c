@@ -0,0 +1,513 @@
+/*
+ * Copyright 1991 by Stichting Mathematisch Centrum
+ * See `LICENCE' for more information.
+ */
+
+/* String module -- common string operations, done in C */
+
+#include <python/state.h>
+#include <python/std.h>
+#include <python/errors.h>
+
+#include <python/module/strop.h>
+
+#include <python/object/module.h>
+#include <python/object/string.h>
+#include <python/object/list.h>
+#include <python/object/tuple.h>
+#include <python/object/int.h>
+#include <python/object/float.h>
+
+/*
+ * Searching (find, count, split with a separator and replace) goes
+ * through py_string_search, which is vectorised where the CPU allows.
+ * Results which would equal an argument are that argument, not a copy.
+ */
+
+/* Unpack n string arguments into v */
+static int py_strop_args(
+		struct py_object* args, unsigned n, struct py_object** v) {
+
+	unsigned i;
+
+	if(n == 1) {
+		if(!args || args->type != PY_TYPE_STRING) {
+			py_error_set_badarg();
+			return 0;
+		}
+
+		v[0] = args;
+
+		return 1;
+	}
+
+	if(!args || args->type != PY_TYPE_TUPLE || py_varobject_size(args) != n) {
+		py_error_set_badarg();
+		return 0;
+	}
+
+	for(i = 0; i < n; i++) {
+		v[i] = py_tuple_get(args, i);
+
+		if(v[i]->type != PY_TYPE_STRING) {
+			py_error_set_badarg();
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/* The offset of sub in s at or after start, or -1 */
+static long py_strop_search(
+		struct py_object* s, unsigned start, struct py_object* sub) {
+
+	unsigned n = py_varobject_size(s);
+	long found;
+
+	if(start > n) return -1;
+
+	found = py_string_search(
+			py_string_get(s) + start, n - start,
+			py_string_get(sub), py_varobject_size(sub));
+
+	return found == -1 ? -1 : found + start;
+}
+
+/* find(s, sub) or find(s, sub, start): the offset of sub in s, or -1 */
+static struct py_object* py_strop_find(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* v[2];
+	struct py_object* start;
+	unsigned i = 0;
+
+	(void) env;
+	(void) self;
+
+	if(args && args->type == PY_TYPE_TUPLE && py_varobject_size(args) == 3) {
+		if((start = py_tuple_get(args, 2))->type != PY_TYPE_INT ||
+			py_int_get(start) < 0) {
+
+			py_error_set_badarg();
+			return 0;
+		}
+
+		i = (unsigned) py_int_get(start);
+		v[0] = py_tuple_get(args, 0);
+		v[1] = py_tuple_get(args, 1);
+
+		if(v[0]->type != PY_TYPE_STRING || v[1]->type != PY_TYPE_STRING) {
+			py_error_set_badarg();
+			return 0;
+		}
+	}
+	else if(!py_strop_args(args, 2, v)) return 0;
+
+	return py_int_new(py_strop_search(v[0], i, v[1]));
+}
+
+/* The number of non-overlapping occurrences of sub in s */
+static unsigned py_strop_occurrences(
+		struct py_object* s, struct py_object* sub) {
+
+	unsigned m = py_varobject_size(sub);
+	unsigned count = 0;
+	long i = 0;
+
+	if(m == 0) return py_varobject_size(s) + 1;
+
+	while((i = py_strop_search(s, (unsigned) i, sub)) != -1) {
+		count++;
+		i += m;
+	}
+
+	return count;
+}
+
+static struct py_object* py_strop_count(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* v[2];
+
+	(void) env;
+	(void) self;
+
+	if(!py_strop_args(args, 2, v)) return 0;
+
+	return py_int_new(py_strop_occurrences(v[0], v[1]));
+}
+
+/* Add s[i:j] to list, returning -1 if out of memory */
+static int py_strop_add_piece(
+		struct py_object* list, struct py_object* s, unsigned i, unsigned j) {
+
+	struct py_object* piece;
+	int err;
+
+	if(!(piece = py_string_slice(s, i, j))) return -1;
+
+	err = py_list_add(list, piece);
+	py_object_decref(piece);
+
+	return err;
+}
+
+/*
+ * split(s) gives the words of s, separated by runs of whitespace; split(s,
+ * sep) gives the pieces between occurrences of sep, which may be empty.
+ */
+static struct py_object* py_strop_split(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* v[2];
+	struct py_object* list;
+	const char* str;
+	unsigned i, j, n;
+
+	(void) env;
+	(void) self;
+
+	if(args && args->type == PY_TYPE_TUPLE) {
+		if(!py_strop_args(args, 2, v)) return 0;
+
+		if(py_varobject_size(v[1]) == 0) {
+			py_error_set_string(py_runtime_error, "empty separator");
+			return 0;
+		}
+	}
+	else {
+		if(!py_strop_args(args, 1, v)) return 0;
+		v[1] = 0;
+	}
+
+	if(!(list = py_list_new(0))) return 0;
+
+	str = py_string_get(v[0]);
+	n = py_varobject_size(v[0]);
+
+	if(v[1]) {
+		unsigned m = py_varobject_size(v[1]);
+		long found;
+
+		for(i = 0; (found = py_strop_search(v[0], i, v[1])) != -1; i = j + m) {
+			j = (unsigned) found;
+			if(py_strop_add_piece(list, v[0], i, j) == -1) goto error;
+		}
+
+		if(py_strop_add_piece(list, v[0], i, n) == -1) goto error;
+	}
+	else {
+		for(i = 0; i < n; i = j) {
+			while(i < n && isspace((unsigned char) str[i])) i++;
+			if(i == n) break;
+
+			for(j = i; j < n && !isspace((unsigned char) str[j]); j++) continue;
+			if(py_strop_add_piece(list, v[0], i, j) == -1) goto error;
+		}
+	}
+
+	return list;
+
+	error: {
+		py_object_decref(list);
+		return 0;
+	}
+}
+
+/*
+ * join(sep, words): as the builtin join. There is no default separator, as
+ * a lone tuple of two strings couldn't be told from (sep, words).
+ */
+static struct py_object* py_strop_join(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* sep;
+
+	(void) env;
+	(void) self;
+
+	if(!args || args->type != PY_TYPE_TUPLE || py_varobject_size(args) != 2 ||
+			(sep = py_tuple_get(args, 0))->type != PY_TYPE_STRING) {
+
+		py_error_set_badarg();
+		return 0;
+	}
+
+	return py_string_join(sep, py_tuple_get(args, 1));
+}
+
+/* replace(s, old, new): s with every occurrence of old replaced by new */
+static struct py_object* py_strop_replace(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* v[3];
+	struct py_object* res;
+	const char* str;
+	const char* rep;
+	char* p;
+	unsigned n, m, r, count, size;
+	unsigned i, j;
+
+	(void) env;
+	(void) self;
+
+	if(!py_strop_args(args, 3, v)) return 0;
+
+	str = py_string_get(v[0]);
+	rep = py_string_get(v[2]);
+	n = py_varobject_size(v[0]);
+	m = py_varobject_size(v[1]);
+	r = py_varobject_size(v[2]);
+
+	if(!(count = py_strop_occurrences(v[0], v[1]))) {
+		return py_object_incref(v[0]);
+	}
+
+	size = n - count * m + count * r;
+	if(r > m && (size - n) / (r - m) != count) return py_error_set_nomem();
+
+	if(!(res = py_string_new_size(0, size))) return 0;
+	if(size == 0) return res;
+
+	p = ((struct py_string*) res)->value;
+
+	if(m == 0) {
+		/* An empty pattern matches around every character. */
+		for(i = 0; i <= n; i++) {
+			memcpy(p, rep, r);
+			p += r;
+			if(i < n) *p++ = str[i];
+		}
+
+		return res;
+	}
+
+	for(i = 0; count--; i = j + m) {
+		j = (unsigned) py_strop_search(v[0], i, v[1]);
+
+		memcpy(p, str + i, j - i);
+		p += j - i;
+		memcpy(p, rep, r);
+		p += r;
+	}
+
+	memcpy(p, str + i, n - i);
+
+	return res;
+}
+
+/* strip(s), lstrip(s) and rstrip(s) take whitespace off either end */
+static struct py_object* py_strop_strip_impl(
+		struct py_object* args, int left, int right) {
+
+	struct py_object* s;
+	const char* str;
+	unsigned i = 0, j;
+
+	if(!py_strop_args(args, 1, &s)) return 0;
+
+	str = py_string_get(s);
+	j = py_varobject_size(s);
+
+	if(left) while(i < j && isspace((unsigned char) str[i])) i++;
+	if(right) while(j > i && isspace((unsigned char) str[j - 1])) j--;
+
+	return py_string_slice(s, i, j);
+}
+
+static struct py_object* py_strop_strip(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+	(void) env;
+	(void) self;
+	return py_strop_strip_impl(args, 1, 1);
+}
+
+static struct py_object* py_strop_lstrip(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+	(void) env;
+	(void) self;
+	return py_strop_strip_impl(args, 1, 0);
+}
+
+static struct py_object* py_strop_rstrip(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+	(void) env;
+	(void) self;
+	return py_strop_strip_impl(args, 0, 1);
+}
+
+static struct py_object* py_strop_case_impl(
+		struct py_object* args, int (*convert)(int)) {
+
+	struct py_object* s;
+	struct py_object* res;
+	const char* str;
+	char* p;
+	unsigned i, n;
+
+	if(!py_strop_args(args, 1, &s)) return 0;
+
+	str = py_string_get(s);
+	n = py_varobject_size(s);
+
+	for(i = 0; i < n; i++) {
+		if(convert((unsigned char) str[i]) != (unsigned char) str[i]) break;
+	}
+
+	if(i == n) return py_object_incref(s);
+
+	/* Not made from str: single characters would be shared ones. */
+	if(!(res = py_string_new_size(0, n))) return 0;
+
+	p = ((struct py_string*) res)->value;
+	memcpy(p, str, i);
+	for(; i < n; i++) p[i] = (char) convert((unsigned char) str[i]);
+
+	return res;
+}
+
+static struct py_object* py_strop_lower(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+	(void) env;
+	(void) self;
+	return py_strop_case_impl(args, tolower);
+}
+
+static struct py_object* py_strop_upper(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+	(void) env;
+	(void) self;
+	return py_strop_case_impl(args, toupper);
+}
+
+static struct py_object* py_strop_affix_impl(
+		struct py_object* args, int suffix) {
+
+	struct py_object* v[2];
+	unsigned n, m;
+	int res;
+
+	if(!py_strop_args(args, 2, v)) return 0;
+
+	n = py_varobject_size(v[0]);
+	m = py_varobject_size(v[1]);
+
+	res = m <= n && !memcmp(
+			py_string_get(v[0]) + (suffix ? n - m : 0), py_string_get(v[1]), m);
+
+	return py_object_incref(res ? PY_TRUE : PY_FALSE);
+}
+
+static struct py_object* py_strop_startswith(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+	(void) env;
+	(void) self;
+	return py_strop_affix_impl(args, 0);
+}
+
+static struct py_object* py_strop_endswith(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+	(void) env;
+	(void) self;
+	return py_strop_affix_impl(args, 1);
+}
+
+/*
+ * atoi(s) and atof(s) convert a decimal number, which may have whitespace
+ * around it. Anything else in s is an error.
+ */
+static int py_strop_number_end(struct py_object* s, const char* end) {
+	const char* str = py_string_get(s);
+	const char* last = str + py_varobject_size(s);
+
+	if(end == str) return 0;
+
+	while(end < last && isspace((unsigned char) *end)) end++;
+
+	return end == last;
+}
+
+static struct py_object* py_strop_atoi(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* s;
+	char* end;
+	long x;
+
+	(void) env;
+	(void) self;
+
+	if(!py_strop_args(args, 1, &s)) return 0;
+
+	errno = 0;
+	x = strtol(py_string_get(s), &end, 10);
+
+	if(!py_strop_number_end(s, end)) {
+		py_error_set_string(py_runtime_error, "invalid literal for atoi()");
+		return 0;
+	}
+
+	if(errno != 0) {
+		py_error_set_string(py_runtime_error, "atoi() literal too large");
+		return 0;
+	}
+
+	return py_int_new(x);
+}
+
+static struct py_object* py_strop_atof(
+		struct py_env* env, struct py_object* self, struct py_object* args) {
+
+	struct py_object* s;
+	char* end;
+	double x;
+
+	(void) env;
+	(void) self;
+
+	if(!py_strop_args(args, 1, &s)) return 0;
+
+	errno = 0;
+	x = strtod(py_string_get(s), &end);
+
+	if(!py_strop_number_end(s, end)) {
+		py_error_set_string(py_runtime_error, "invalid literal for atof()");
+		return 0;
+	}
+
+	if(errno != 0 && fabs(x) > 1.0) {
+		py_error_set_string(py_runtime_error, "atof() literal too large");
+		return 0;
+	}
+
+	return py_float_new(x);
+}
+
+enum py_result py_strop_init(struct py_env* env) {
+#define py_(func) { #func, py_strop_##func }
+	static const struct py_methodlist methods[] = {
+			py_(find),
+			py_(count),
+			py_(split),
+			py_(join),
+			py_(replace),
+			py_(strip),
+			py_(lstrip),
+			py_(rstrip),
+			py_(lower),
+			py_(upper),
+			py_(startswith),
+			py_(endswith),
+			py_(atoi),
+			py_(atof),
+			{ NULL, NULL } /* sentinel */
+	};
+#undef py_
+
+	if(!(py_module_new_methods(env, "string", methods))) {
+		return PY_RESULT_ERROR;
+	}
+
+	return PY_RESULT_OK;
+}
@@ -6,10 +6,11 @@
 /* Parse tree node implementation */
 
 #include <python/std.h>
+#include <python/alloc.h>
 #include <python/node.h>
 
 struct py_node* py_tree_new(int type) {
-	struct py_node* n = malloc(sizeof(struct py_node));
+	struct py_node* n = py_malloc(sizeof(struct py_node));
 	if(n == NULL) {
 		return NULL;
 	}
@@ -40,11 +41,9 @@ struct py_node* py_tree_add(
 		n = n1->children;
 		nch1 = PY_ROUND_UP(nch1);
 
-		newptr = realloc(n, nch1 * sizeof(struct py_node));
-		if(newptr == NULL) {
-			free(n);
-			return NULL;
-		}
+		/* On failure the node keeps its children, for py_tree_delete. */
+		newptr = py_realloc(n, nch1 * sizeof(struct py_node));
+		if(newptr == NULL) return NULL;
 		n = newptr;
 
 		n1->children = n;
@@ -63,13 +62,13 @@ static void py_tree_free_children(struct py_node* n) {
 
 	for(i = 0; i < n->count; ++i) py_tree_free_children(&n->children[i]);
 
-	if(n->children != NULL) free(n->children);
-	if(n->str != NULL) free(n->str);
+	if(n->children != NULL) py_free(n->children);
+	if(n->str != NULL) py_free(n->str);
 }
 
 void py_tree_delete(struct py_node* n) {
 	if(n != NULL) {
 		py_tree_free_children(n);
-		free(n);
+		py_free(n);
 	}
 }
@@ -5,7 +5,15 @@
 
 /* Generic object operations; and implementation of PY_NONE (py_none_object) */
 
+/*
+ * The out-of-line py_object_incref and py_object_decref are always defined
+ * here, whatever the library itself is built with, so that code built with
+ * reference debugging (or PY_NO_REF_INLINE) links against any build.
+ */
+#define PY_NO_REF_INLINE
+
 #include <python/std.h>
+#include <python/alloc.h>
 #include <python/errors.h>
 
 /*
@@ -14,7 +22,7 @@
  * Do not call them otherwise, they do not initialize the object!
  */
 void* py_object_new(enum py_type tp) {
-	struct py_object* op = malloc(py_types[tp].size);
+	struct py_object* op = py_malloc(py_types[tp].size);
 	if(op == NULL) return py_error_set_nomem();
 
 	py_object_newref(op);
@@ -38,13 +46,28 @@ int py_is_varobject(const void* op) {
 	enum py_type type = ((struct py_varobject*) op)->type;
 
 	return type == PY_TYPE_LIST || type == PY_TYPE_TUPLE ||
-			type == PY_TYPE_STRING;
+			type == PY_TYPE_STRING || type == PY_TYPE_ARRAY;
 }
 
 unsigned py_varobject_size(const void* op) {
 	return ((struct py_varobject*) op)->size;
 }
 
+int py_varobject_truthy(struct py_object* op) {
+	return ((struct py_varobject*) op)->size != 0;
+}
+
+long py_object_hash(struct py_object* op) {
+	py_hash_t hash = py_types[op->type].hash;
+
+	if(!hash) {
+		py_error_set_string(py_type_error, "unhashable object");
+		return -1;
+	}
+
+	return hash(op);
+}
+
 /*
  * `py_none_object' is usable as a non-NULL undefined value, used by the macro
  * PY_NONE. There is (and should be!) no way to create other objects of this
@@ -53,7 +76,7 @@ unsigned py_varobject_size(const void* op) {
 
 struct py_object py_none_object = { PY_TYPE_NONE, 1 };
 
-void py_object_delete(struct py_object* p) { (void) p; }
+void py_object_delete(struct py_object* p) { py_free(p); }
 
 #ifdef PY_REF_TRACE
 /* TODO: Python global state. */
@@ -64,6 +87,32 @@ static object py_refchain = { &py_refchain, &py_refchain };
 long py_ref_total;
 #endif
 
+/*
+ * Deferred deallocation. Container deallocators drop their items through
+ * `py_object_release', which puts any item that dies on the queue below
+ * instead of deallocating it on the spot. This keeps dropping a deep
+ * chain of containers from recursing once per level, and lets the
+ * embedder spread freeing a large object graph over several calls to
+ * `py_object_drain' when deferral is switched on.
+ */
+
+#define PY_DEALLOC_QUEUE_MIN (64)
+#define PY_DEALLOC_CHECK_CLOCK (32) /* Objects between polls of clock() */
+
+/* TODO: Python global state. */
+static struct py_object** py_dealloc_queue = NULL;
+static unsigned py_dealloc_queue_len = 0;
+static unsigned py_dealloc_queue_max = 0;
+static int py_dealloc_deferred = 0;
+static int py_dealloc_draining = 0;
+
+void py_object_dealloc(struct py_object* op) {
+	py_object_unref(op);
+	py_types[op->type].dealloc(op);
+
+	if(py_dealloc_queue_len && !py_dealloc_deferred) py_object_drain(0, 0);
+}
+
 void* py_object_incref(void* p) {
 	struct py_object* op = p;
 
@@ -93,13 +142,86 @@ void* py_object_decref(void* p) {
 #ifdef PY_REF_TRACE
 #endif
 
-	if(op->refcount-- <= 0) {
-		py_object_unref(op);
+	if(--op->refcount == 0) py_object_dealloc(op);
+
+	return op;
+}
+
+static int py_dealloc_queue_push(struct py_object* op) {
+	if(py_dealloc_queue_len == py_dealloc_queue_max) {
+		unsigned max = py_dealloc_queue_max * 2;
+		void* newptr;
+
+		if(max < PY_DEALLOC_QUEUE_MIN) max = PY_DEALLOC_QUEUE_MIN;
+
+		newptr = py_realloc(py_dealloc_queue, max * sizeof(struct py_object*));
+		if(!newptr) return -1;
+
+		py_dealloc_queue = newptr;
+		py_dealloc_queue_max = max;
+	}
+
+	py_dealloc_queue[py_dealloc_queue_len++] = op;
+
+	return 0;
+}
+
+void py_object_release(void* p) {
+	struct py_object* op = p;
+
+	if(!p) return;
+
+#ifdef PY_REF_DEBUG
+	py_ref_total--;
+#endif
+
+	if(--op->refcount != 0) return;
+
+	py_object_unref(op);
+
+	/*
+	 * Objects which can't hold references are freed right away, as is
+	 * anything we fail to queue.
+	 */
+	if(op->type == PY_TYPE_INT || op->type == PY_TYPE_FLOAT ||
+		op->type == PY_TYPE_STRING || py_dealloc_queue_push(op) == -1) {
+
 		py_types[op->type].dealloc(op);
-		free(op);
 	}
+}
 
-	return op;
+void py_object_set_deferred(int deferred) {
+	py_dealloc_deferred = deferred;
+}
+
+unsigned py_object_pending(void) {
+	return py_dealloc_queue_len;
+}
+
+unsigned py_object_drain(unsigned max, clock_t ticks) {
+	clock_t start = ticks ? clock() : 0;
+	unsigned n = 0;
+
+	/* The outermost drain empties the queue for anything released below. */
+	if(py_dealloc_draining) return py_dealloc_queue_len;
+
+	py_dealloc_draining = 1;
+
+	while(py_dealloc_queue_len) {
+		struct py_object* op = py_dealloc_queue[--py_dealloc_queue_len];
+
+		py_types[op->type].dealloc(op);
+
+		if(++n == max) break;
+
+		if(ticks && !(n % PY_DEALLOC_CHECK_CLOCK)) {
+			if(clock() - start >= ticks) break;
+		}
+	}
+
+	py_dealloc_draining = 0;
+
+	return py_dealloc_queue_len;
 }
 
 void* py_object_newref(void* p) {
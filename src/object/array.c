@@ -0,0 +1,256 @@
+/*
+ * Copyright 1991 by Stichting Mathematisch Centrum
+ * See `LICENCE' for more information.
+ */
+
+/* Array object implementation */
+
+#include <python/std.h>
+#include <python/alloc.h>
+#include <python/errors.h>
+
+#include <python/object/array.h>
+#include <python/object/list.h>
+#include <python/object/tuple.h>
+#include <python/object/int.h>
+#include <python/object/float.h>
+
+static const unsigned py_array_item_sizes[PY_ARRAY_MAX] = {
+		sizeof(py_int32_t), sizeof(float), sizeof(double)
+};
+
+unsigned py_array_item_size(enum py_array_kind kind) {
+	return py_array_item_sizes[kind];
+}
+
+enum py_array_kind py_array_kind_for(char code) {
+	switch(code) {
+		default: return PY_ARRAY_MAX;
+
+		case 'i': return PY_ARRAY_INT32;
+		case 'f': return PY_ARRAY_FLOAT32;
+		case 'd': return PY_ARRAY_FLOAT64;
+	}
+}
+
+struct py_object* py_array_new(enum py_array_kind kind, unsigned size) {
+	struct py_array* op;
+
+	if(!(op = py_object_new(PY_TYPE_ARRAY))) return 0;
+
+	op->ob.size = size;
+	op->kind = kind;
+
+	/* All bits zero is 0 and 0.0 for each of the kinds. */
+	if(!(op->data = py_calloc(size ? size : 1, py_array_item_sizes[kind]))) {
+		py_free(op);
+		return py_error_set_nomem();
+	}
+
+	return (void*) op;
+}
+
+/* Item i as a double; exact for each of the kinds. */
+static double py_array_get_double(const struct py_object* op, unsigned i) {
+	switch(((struct py_array*) op)->kind) {
+		default: return PY_ARRAY_FLOAT64_DATA(op)[i];
+
+		case PY_ARRAY_INT32: return PY_ARRAY_INT32_DATA(op)[i];
+		case PY_ARRAY_FLOAT32: return PY_ARRAY_FLOAT32_DATA(op)[i];
+	}
+}
+
+int py_array_set(struct py_object* op, unsigned i, struct py_object* v) {
+	struct py_array* ap = (void*) op;
+
+	if(ap->kind == PY_ARRAY_INT32) {
+		py_value_t x;
+
+		if(v->type != PY_TYPE_INT) {
+			py_error_set_string(py_type_error, "int array item must be int");
+			return -1;
+		}
+
+		x = py_int_get(v);
+		if(x < -2147483647L - 1 || x > 2147483647L) {
+			py_error_set_string(
+					py_runtime_error, "int out of range for int array");
+			return -1;
+		}
+
+		PY_ARRAY_INT32_DATA(op)[i] = (py_int32_t) x;
+
+		return 0;
+	}
+	else {
+		double d;
+
+		if(v->type == PY_TYPE_FLOAT) d = py_float_get(v);
+		else if(v->type == PY_TYPE_INT) d = (double) py_int_get(v);
+		else {
+			py_error_set_string(
+					py_type_error, "float array item must be a number");
+			return -1;
+		}
+
+		if(ap->kind == PY_ARRAY_FLOAT32) PY_ARRAY_FLOAT32_DATA(op)[i] = (float) d;
+		else PY_ARRAY_FLOAT64_DATA(op)[i] = d;
+
+		return 0;
+	}
+}
+
+struct py_object* py_array_from_seq(
+		enum py_array_kind kind, struct py_object* v) {
+
+	struct py_object* op;
+	struct py_object** items;
+	unsigned i, n;
+
+	if(v->type == PY_TYPE_LIST) items = ((struct py_list*) v)->item;
+	else if(v->type == PY_TYPE_TUPLE) items = ((struct py_tuple*) v)->item;
+	else if(v->type != PY_TYPE_ARRAY) {
+		py_error_set_badarg();
+		return 0;
+	}
+	else items = 0;
+
+	n = py_varobject_size(v);
+
+	if(!(op = py_array_new(kind, n))) return 0;
+
+	if(items) {
+		for(i = 0; i < n; i++) {
+			if(py_array_set(op, i, items[i]) == -1) {
+				py_object_decref(op);
+				return 0;
+			}
+		}
+	}
+	else if(((struct py_array*) v)->kind == kind) {
+		memcpy(
+				((struct py_array*) op)->data, ((struct py_array*) v)->data,
+				n * py_array_item_sizes[kind]);
+	}
+	else {
+		for(i = 0; i < n; i++) {
+			double d = py_array_get_double(v, i);
+
+			switch(kind) {
+				default: PY_ARRAY_FLOAT64_DATA(op)[i] = d; break;
+
+				case PY_ARRAY_INT32: {
+					/* Written so that NaN fails too. */
+					if(!(d > -2147483649.0 && d < 2147483648.0)) {
+						py_error_set_string(
+								py_runtime_error,
+								"float out of range for int array");
+						py_object_decref(op);
+						return 0;
+					}
+
+					PY_ARRAY_INT32_DATA(op)[i] = (py_int32_t) d;
+					break;
+				}
+				case PY_ARRAY_FLOAT32: {
+					PY_ARRAY_FLOAT32_DATA(op)[i] = (float) d;
+					break;
+				}
+			}
+		}
+	}
+
+	return op;
+}
+
+struct py_object* py_array_to_list(struct py_object* op) {
+	struct py_list* lp;
+	unsigned i, n = py_varobject_size(op);
+
+	if(!(lp = (void*) py_list_new(n))) return 0;
+
+	for(i = 0; i < n; i++) {
+		if(!(lp->item[i] = py_array_ind(op, i))) {
+			py_object_decref(lp);
+			return 0;
+		}
+	}
+
+	return (void*) lp;
+}
+
+void py_array_dealloc(struct py_object* op) {
+	py_free(((struct py_array*) op)->data);
+	py_free(op);
+}
+
+/* Arrays compare item by item by value, whatever their kinds. */
+int py_array_cmp(const struct py_object* v, const struct py_object* w) {
+	unsigned i;
+	unsigned a = py_varobject_size(v);
+	unsigned b = py_varobject_size(w);
+	unsigned len = (a < b) ? a : b;
+
+	for(i = 0; i < len; i++) {
+		double x = py_array_get_double(v, i);
+		double y = py_array_get_double(w, i);
+
+		if(x != y) return (x < y) ? -1 : 1;
+	}
+
+	return (int) (a - b);
+}
+
+struct py_object* py_array_ind(struct py_object* op, unsigned i) {
+	switch(((struct py_array*) op)->kind) {
+		default: return py_float_new(PY_ARRAY_FLOAT64_DATA(op)[i]);
+
+		case PY_ARRAY_INT32: return py_int_new(PY_ARRAY_INT32_DATA(op)[i]);
+		case PY_ARRAY_FLOAT32: return py_float_new(PY_ARRAY_FLOAT32_DATA(op)[i]);
+	}
+}
+
+struct py_object* py_array_slice(
+		struct py_object* op, unsigned low, unsigned high) {
+
+	struct py_array* ap = (void*) op;
+	struct py_array* np;
+	unsigned itemsize = py_array_item_sizes[ap->kind];
+
+	if(low > ap->ob.size) low = ap->ob.size;
+
+	if(high < low) high = low;
+	else if(high > ap->ob.size) high = ap->ob.size;
+
+	if(!(np = (void*) py_array_new(ap->kind, high - low))) return 0;
+
+	memcpy(
+			np->data, (char*) ap->data + low * itemsize,
+			(high - low) * itemsize);
+
+	return (void*) np;
+}
+
+struct py_object* py_array_cat(struct py_object* a, struct py_object* b) {
+	struct py_array* ap = (void*) a;
+	struct py_array* bp = (void*) b;
+	struct py_array* np;
+	unsigned itemsize = py_array_item_sizes[ap->kind];
+
+	if(ap->kind != bp->kind) {
+		py_error_set_string(
+				py_type_error, "can only concatenate arrays of the same kind");
+		return 0;
+	}
+
+	if(!(np = (void*) py_array_new(ap->kind, ap->ob.size + bp->ob.size))) {
+		return 0;
+	}
+
+	memcpy(np->data, ap->data, ap->ob.size * itemsize);
+	memcpy(
+			(char*) np->data + ap->ob.size * itemsize, bp->data,
+			bp->ob.size * itemsize);
+
+	return (void*) np;
+}
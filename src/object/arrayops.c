@@ -0,0 +1,928 @@
+/*
+ * Copyright 1991 by Stichting Mathematisch Centrum
+ * See `LICENCE' for more information.
+ */
+
+/* Array arithmetic, reductions and functions mapped over arrays */
+
+#include <python/std.h>
+#include <python/errors.h>
+
+#include <python/object/array.h>
+#include <python/object/int.h>
+#include <python/object/float.h>
+
+/*
+ * The loops over float arrays come in SSE2 and AVX2 flavours as well as
+ * plain C, and the best the CPU supports is picked on first use. The
+ * vector code is only built with GCC-compatible compilers for x86; define
+ * PY_NO_SIMD to go without. Int arrays, and the less common cases for
+ * float ones, are left as simple loops for the compiler to vectorise.
+ * Vector reductions add up in a different order to a plain loop, so sums
+ * may differ in the last bits.
+ */
+#if !defined(PY_NO_SIMD) && defined(__GNUC__) && \
+	(defined(__x86_64__) || defined(__i386__))
+# define PY_ARRAY_SIMD
+# include <immintrin.h>
+# define PY_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#ifdef PY_ARRAY_SIMD
+enum py_array_isa {
+	PY_ARRAY_ISA_UNKNOWN,
+	PY_ARRAY_ISA_SCALAR,
+	PY_ARRAY_ISA_SSE2,
+	PY_ARRAY_ISA_AVX2
+};
+
+/* TODO: Python global state. */
+static enum py_array_isa py_array_isa = PY_ARRAY_ISA_UNKNOWN;
+
+static enum py_array_isa py_array_get_isa(void) {
+	if(py_array_isa == PY_ARRAY_ISA_UNKNOWN) {
+		__builtin_cpu_init();
+
+		if(__builtin_cpu_supports("avx2")) py_array_isa = PY_ARRAY_ISA_AVX2;
+		else if(__builtin_cpu_supports("sse2")) {
+			py_array_isa = PY_ARRAY_ISA_SSE2;
+		}
+		else py_array_isa = PY_ARRAY_ISA_SCALAR;
+	}
+
+	return py_array_isa;
+}
+#endif
+
+/*
+ * Elementwise kernels: out[i] = a[i * as] op b[i * bs], where the strides
+ * are 1 for an array and 0 for a scalar operand. out may be a or b.
+ */
+
+static void py_array_f64_scalar(
+		enum py_binary_op op, const double* a, unsigned as,
+		const double* b, unsigned bs, double* out, unsigned n) {
+
+	unsigned i;
+
+	switch(op) {
+		default: break;
+
+		case PY_BINARY_ADD: {
+			for(i = 0; i < n; i++) out[i] = a[i * as] + b[i * bs];
+			break;
+		}
+		case PY_BINARY_SUB: {
+			for(i = 0; i < n; i++) out[i] = a[i * as] - b[i * bs];
+			break;
+		}
+		case PY_BINARY_MUL: {
+			for(i = 0; i < n; i++) out[i] = a[i * as] * b[i * bs];
+			break;
+		}
+		case PY_BINARY_DIV: {
+			for(i = 0; i < n; i++) out[i] = a[i * as] / b[i * bs];
+			break;
+		}
+		case PY_BINARY_MOD: {
+			for(i = 0; i < n; i++) out[i] = fmod(a[i * as], b[i * bs]);
+			break;
+		}
+	}
+}
+
+static void py_array_f32_scalar(
+		enum py_binary_op op, const float* a, unsigned as,
+		const float* b, unsigned bs, float* out, unsigned n) {
+
+	unsigned i;
+
+	switch(op) {
+		default: break;
+
+		case PY_BINARY_ADD: {
+			for(i = 0; i < n; i++) out[i] = a[i * as] + b[i * bs];
+			break;
+		}
+		case PY_BINARY_SUB: {
+			for(i = 0; i < n; i++) out[i] = a[i * as] - b[i * bs];
+			break;
+		}
+		case PY_BINARY_MUL: {
+			for(i = 0; i < n; i++) out[i] = a[i * as] * b[i * bs];
+			break;
+		}
+		case PY_BINARY_DIV: {
+			for(i = 0; i < n; i++) out[i] = a[i * as] / b[i * bs];
+			break;
+		}
+		case PY_BINARY_MOD: {
+			for(i = 0; i < n; i++) {
+				out[i] = (float) fmod(a[i * as], b[i * bs]);
+			}
+			break;
+		}
+	}
+}
+
+#ifdef PY_ARRAY_SIMD
+/*
+ * Run a vector loop of width w over as much of the operands as it covers,
+ * leaving i at the first item not done. va and vb hold the operands
+ * broadcast, for when they are scalars.
+ */
+# define PY_ARRAY_VLOOP(w, load, vop, store) \
+	for(; i + (w) <= n; i += (w)) { \
+		store(out + i, vop(as ? load(a + i) : va, bs ? load(b + i) : vb)); \
+	}
+
+static PY_TARGET("sse2") unsigned py_array_f64_sse2(
+		enum py_binary_op op, const double* a, unsigned as,
+		const double* b, unsigned bs, double* out, unsigned n) {
+
+	unsigned i = 0;
+	__m128d va = _mm_set1_pd(*a);
+	__m128d vb = _mm_set1_pd(*b);
+
+	switch(op) {
+		default: break;
+
+		case PY_BINARY_ADD: {
+			PY_ARRAY_VLOOP(2, _mm_loadu_pd, _mm_add_pd, _mm_storeu_pd);
+			break;
+		}
+		case PY_BINARY_SUB: {
+			PY_ARRAY_VLOOP(2, _mm_loadu_pd, _mm_sub_pd, _mm_storeu_pd);
+			break;
+		}
+		case PY_BINARY_MUL: {
+			PY_ARRAY_VLOOP(2, _mm_loadu_pd, _mm_mul_pd, _mm_storeu_pd);
+			break;
+		}
+		case PY_BINARY_DIV: {
+			PY_ARRAY_VLOOP(2, _mm_loadu_pd, _mm_div_pd, _mm_storeu_pd);
+			break;
+		}
+	}
+
+	return i;
+}
+
+static PY_TARGET("avx2") unsigned py_array_f64_avx2(
+		enum py_binary_op op, const double* a, unsigned as,
+		const double* b, unsigned bs, double* out, unsigned n) {
+
+	unsigned i = 0;
+	__m256d va = _mm256_set1_pd(*a);
+	__m256d vb = _mm256_set1_pd(*b);
+
+	switch(op) {
+		default: break;
+
+		case PY_BINARY_ADD: {
+			PY_ARRAY_VLOOP(4, _mm256_loadu_pd, _mm256_add_pd, _mm256_storeu_pd);
+			break;
+		}
+		case PY_BINARY_SUB: {
+			PY_ARRAY_VLOOP(4, _mm256_loadu_pd, _mm256_sub_pd, _mm256_storeu_pd);
+			break;
+		}
+		case PY_BINARY_MUL: {
+			PY_ARRAY_VLOOP(4, _mm256_loadu_pd, _mm256_mul_pd, _mm256_storeu_pd);
+			break;
+		}
+		case PY_BINARY_DIV: {
+			PY_ARRAY_VLOOP(4, _mm256_loadu_pd, _mm256_div_pd, _mm256_storeu_pd);
+			break;
+		}
+	}
+
+	return i;
+}
+
+static PY_TARGET("sse2") unsigned py_array_f32_sse2(
+		enum py_binary_op op, const float* a, unsigned as,
+		const float* b, unsigned bs, float* out, unsigned n) {
+
+	unsigned i = 0;
+	__m128 va = _mm_set1_ps(*a);
+	__m128 vb = _mm_set1_ps(*b);
+
+	switch(op) {
+		default: break;
+
+		case PY_BINARY_ADD: {
+			PY_ARRAY_VLOOP(4, _mm_loadu_ps, _mm_add_ps, _mm_storeu_ps);
+			break;
+		}
+		case PY_BINARY_SUB: {
+			PY_ARRAY_VLOOP(4, _mm_loadu_ps, _mm_sub_ps, _mm_storeu_ps);
+			break;
+		}
+		case PY_BINARY_MUL: {
+			PY_ARRAY_VLOOP(4, _mm_loadu_ps, _mm_mul_ps, _mm_storeu_ps);
+			break;
+		}
+		case PY_BINARY_DIV: {
+			PY_ARRAY_VLOOP(4, _mm_loadu_ps, _mm_div_ps, _mm_storeu_ps);
+			break;
+		}
+	}
+
+	return i;
+}
+
+static PY_TARGET("avx2") unsigned py_array_f32_avx2(
+		enum py_binary_op op, const float* a, unsigned as,
+		const float* b, unsigned bs, float* out, unsigned n) {
+
+	unsigned i = 0;
+	__m256 va = _mm256_set1_ps(*a);
+	__m256 vb = _mm256_set1_ps(*b);
+
+	switch(op) {
+		default: break;
+
+		case PY_BINARY_ADD: {
+			PY_ARRAY_VLOOP(8, _mm256_loadu_ps, _mm256_add_ps, _mm256_storeu_ps);
+			break;
+		}
+		case PY_BINARY_SUB: {
+			PY_ARRAY_VLOOP(8, _mm256_loadu_ps, _mm256_sub_ps, _mm256_storeu_ps);
+			break;
+		}
+		case PY_BINARY_MUL: {
+			PY_ARRAY_VLOOP(8, _mm256_loadu_ps, _mm256_mul_ps, _mm256_storeu_ps);
+			break;
+		}
+		case PY_BINARY_DIV: {
+			PY_ARRAY_VLOOP(8, _mm256_loadu_ps, _mm256_div_ps, _mm256_storeu_ps);
+			break;
+		}
+	}
+
+	return i;
+}
+
+# undef PY_ARRAY_VLOOP
+#endif
+
+static void py_array_f64(
+		enum py_binary_op op, const double* a, unsigned as,
+		const double* b, unsigned bs, double* out, unsigned n) {
+
+	unsigned i = 0;
+
+#ifdef PY_ARRAY_SIMD
+	switch(py_array_get_isa()) {
+		default: break;
+
+		case PY_ARRAY_ISA_AVX2: {
+			i = py_array_f64_avx2(op, a, as, b, bs, out, n);
+			break;
+		}
+		case PY_ARRAY_ISA_SSE2: {
+			i = py_array_f64_sse2(op, a, as, b, bs, out, n);
+			break;
+		}
+	}
+#endif
+
+	py_array_f64_scalar(op, a + i * as, as, b + i * bs, bs, out + i, n - i);
+}
+
+static void py_array_f32(
+		enum py_binary_op op, const float* a, unsigned as,
+		const float* b, unsigned bs, float* out, unsigned n) {
+
+	unsigned i = 0;
+
+#ifdef PY_ARRAY_SIMD
+	switch(py_array_get_isa()) {
+		default: break;
+
+		case PY_ARRAY_ISA_AVX2: {
+			i = py_array_f32_avx2(op, a, as, b, bs, out, n);
+			break;
+		}
+		case PY_ARRAY_ISA_SSE2: {
+			i = py_array_f32_sse2(op, a, as, b, bs, out, n);
+			break;
+		}
+	}
+#endif
+
+	py_array_f32_scalar(op, a + i * as, as, b + i * bs, bs, out + i, n - i);
+}
+
+/*
+ * Int arrays wrap around on overflow, like the 32-bit ints they hold;
+ * the arithmetic is done unsigned so that this is well defined. Division
+ * truncates, as for int objects.
+ */
+static int py_array_i32(
+		enum py_binary_op op, const py_int32_t* a, unsigned as,
+		const py_int32_t* b, unsigned bs, py_int32_t* out, unsigned n) {
+
+	unsigned i;
+
+	if(op == PY_BINARY_DIV || op == PY_BINARY_MOD) {
+		for(i = 0; i < n; i++) {
+			if(b[i * bs] == 0) {
+				py_error_set_string(
+						py_runtime_error, op == PY_BINARY_DIV ?
+						"integer division by zero" : "integer modulo by zero");
+				return -1;
+			}
+		}
+	}
+
+	switch(op) {
+		default: break;
+
+		case PY_BINARY_ADD: {
+			for(i = 0; i < n; i++) {
+				out[i] = (py_int32_t)
+						((unsigned long) a[i * as] + (unsigned long) b[i * bs]);
+			}
+			break;
+		}
+		case PY_BINARY_SUB: {
+			for(i = 0; i < n; i++) {
+				out[i] = (py_int32_t)
+						((unsigned long) a[i * as] - (unsigned long) b[i * bs]);
+			}
+			break;
+		}
+		case PY_BINARY_MUL: {
+			for(i = 0; i < n; i++) {
+				out[i] = (py_int32_t)
+						((unsigned long) a[i * as] * (unsigned long) b[i * bs]);
+			}
+			break;
+		}
+		case PY_BINARY_DIV: {
+			for(i = 0; i < n; i++) {
+				/* The most negative value over -1 overflows. */
+				if(b[i * bs] == -1) {
+					out[i] = (py_int32_t) (0UL - (unsigned long) a[i * as]);
+				}
+				else out[i] = a[i * as] / b[i * bs];
+			}
+			break;
+		}
+		case PY_BINARY_MOD: {
+			for(i = 0; i < n; i++) {
+				out[i] = b[i * bs] == -1 ? 0 : a[i * as] % b[i * bs];
+			}
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/* The scalar operand of a binary op, as one item of the given kind. */
+union py_array_scalar {
+	py_int32_t i32;
+	float f32;
+	double f64;
+};
+
+static int py_array_get_scalar(
+		enum py_array_kind kind, struct py_object* v,
+		union py_array_scalar* sp) {
+
+	double d;
+
+	if(kind == PY_ARRAY_INT32) {
+		py_value_t x;
+
+		if(v->type != PY_TYPE_INT) {
+			py_error_set_string(
+					py_type_error, "int array operand must be int");
+			return -1;
+		}
+
+		x = py_int_get(v);
+		if(x < -2147483647L - 1 || x > 2147483647L) {
+			py_error_set_string(
+					py_runtime_error, "int out of range for int array");
+			return -1;
+		}
+
+		sp->i32 = (py_int32_t) x;
+
+		return 0;
+	}
+
+	if(v->type == PY_TYPE_FLOAT) d = py_float_get(v);
+	else d = (double) py_int_get(v);
+
+	if(kind == PY_ARRAY_FLOAT32) sp->f32 = (float) d;
+	else sp->f64 = d;
+
+	return 0;
+}
+
+/*
+ * v op w, where at least one of them is an array and the other an array
+ * of the same kind and size, or an int or float.
+ */
+static struct py_object* py_array_binary(
+		enum py_binary_op op, struct py_object* v, struct py_object* w) {
+
+	union py_array_scalar scalar;
+	struct py_object* res;
+	struct py_array* ap;
+	const void* a;
+	const void* b;
+	unsigned as = 1, bs = 1;
+	unsigned n;
+	int err = 0;
+
+	ap = (void*) (v->type == PY_TYPE_ARRAY ? v : w);
+	n = ap->ob.size;
+
+	if(v->type == PY_TYPE_ARRAY && w->type == PY_TYPE_ARRAY) {
+		if(((struct py_array*) v)->kind != ((struct py_array*) w)->kind) {
+			py_error_set_string(
+					py_type_error, "array operands of different kinds");
+			return 0;
+		}
+
+		if(py_varobject_size(v) != py_varobject_size(w)) {
+			py_error_set_string(
+					py_runtime_error, "array operands of different sizes");
+			return 0;
+		}
+
+		a = ((struct py_array*) v)->data;
+		b = ((struct py_array*) w)->data;
+	}
+	else if(v->type == PY_TYPE_ARRAY) {
+		if(py_array_get_scalar(ap->kind, w, &scalar) == -1) return 0;
+
+		a = ap->data;
+		b = &scalar;
+		bs = 0;
+	}
+	else {
+		if(py_array_get_scalar(ap->kind, v, &scalar) == -1) return 0;
+
+		a = &scalar;
+		as = 0;
+		b = ap->data;
+	}
+
+	if(!(res = py_array_new(ap->kind, n))) return 0;
+
+	switch(ap->kind) {
+		default: break;
+
+		case PY_ARRAY_INT32: {
+			err = py_array_i32(op, a, as, b, bs, PY_ARRAY_INT32_DATA(res), n);
+			break;
+		}
+		case PY_ARRAY_FLOAT32: {
+			py_array_f32(op, a, as, b, bs, PY_ARRAY_FLOAT32_DATA(res), n);
+			break;
+		}
+		case PY_ARRAY_FLOAT64: {
+			py_array_f64(op, a, as, b, bs, PY_ARRAY_FLOAT64_DATA(res), n);
+			break;
+		}
+	}
+
+	if(err) {
+		py_object_decref(res);
+		return 0;
+	}
+
+	return res;
+}
+
+static struct py_object* py_array_add(
+		struct py_object* v, struct py_object* w) {
+
+	return py_array_binary(PY_BINARY_ADD, v, w);
+}
+
+static struct py_object* py_array_sub(
+		struct py_object* v, struct py_object* w) {
+
+	return py_array_binary(PY_BINARY_SUB, v, w);
+}
+
+static struct py_object* py_array_mul(
+		struct py_object* v, struct py_object* w) {
+
+	return py_array_binary(PY_BINARY_MUL, v, w);
+}
+
+static struct py_object* py_array_div(
+		struct py_object* v, struct py_object* w) {
+
+	return py_array_binary(PY_BINARY_DIV, v, w);
+}
+
+static struct py_object* py_array_mod(
+		struct py_object* v, struct py_object* w) {
+
+	return py_array_binary(PY_BINARY_MOD, v, w);
+}
+
+static struct py_object* py_array_neg(struct py_object* v) {
+	struct py_array* ap = (void*) v;
+	struct py_object* res;
+	unsigned i;
+
+	if(!(res = py_array_new(ap->kind, ap->ob.size))) return 0;
+
+	switch(ap->kind) {
+		default: break;
+
+		case PY_ARRAY_INT32: {
+			for(i = 0; i < ap->ob.size; i++) {
+				PY_ARRAY_INT32_DATA(res)[i] = (py_int32_t)
+						(0UL - (unsigned long) PY_ARRAY_INT32_DATA(v)[i]);
+			}
+			break;
+		}
+		case PY_ARRAY_FLOAT32: {
+			for(i = 0; i < ap->ob.size; i++) {
+				PY_ARRAY_FLOAT32_DATA(res)[i] = -PY_ARRAY_FLOAT32_DATA(v)[i];
+			}
+			break;
+		}
+		case PY_ARRAY_FLOAT64: {
+			for(i = 0; i < ap->ob.size; i++) {
+				PY_ARRAY_FLOAT64_DATA(res)[i] = -PY_ARRAY_FLOAT64_DATA(v)[i];
+			}
+			break;
+		}
+	}
+
+	return res;
+}
+
+const struct py_number_methods py_array_number = {
+		py_array_add, py_array_sub, py_array_mul, py_array_div, py_array_mod,
+		py_array_neg
+};
+
+/* Reductions */
+
+static double py_array_combine(
+		enum py_array_reduction r, double x, double y) {
+
+	switch(r) {
+		default: return x + y;
+
+		case PY_ARRAY_REDUCE_MIN: return y < x ? y : x;
+		case PY_ARRAY_REDUCE_MAX: return y > x ? y : x;
+	}
+}
+
+#ifdef PY_ARRAY_SIMD
+/*
+ * These reduce all but the last few items of a (of which there are at
+ * least enough to fill a vector) into *res, returning how many they did.
+ */
+static PY_TARGET("sse2") unsigned py_array_reduce_sse2(
+		enum py_array_reduction r, const double* a, unsigned n,
+		double* res) {
+
+	unsigned i;
+	double lanes[2];
+	__m128d acc = _mm_loadu_pd(a);
+
+	for(i = 2; i + 2 <= n; i += 2) {
+		__m128d x = _mm_loadu_pd(a + i);
+
+		switch(r) {
+			default: acc = _mm_add_pd(acc, x); break;
+
+			case PY_ARRAY_REDUCE_MIN: acc = _mm_min_pd(acc, x); break;
+			case PY_ARRAY_REDUCE_MAX: acc = _mm_max_pd(acc, x); break;
+		}
+	}
+
+	_mm_storeu_pd(lanes, acc);
+	*res = py_array_combine(r, lanes[0], lanes[1]);
+
+	return i;
+}
+
+static PY_TARGET("avx2") unsigned py_array_reduce_avx2(
+		enum py_array_reduction r, const double* a, unsigned n,
+		double* res) {
+
+	unsigned i, j;
+	double lanes[4];
+	__m256d acc = _mm256_loadu_pd(a);
+
+	for(i = 4; i + 4 <= n; i += 4) {
+		__m256d x = _mm256_loadu_pd(a + i);
+
+		switch(r) {
+			default: acc = _mm256_add_pd(acc, x); break;
+
+			case PY_ARRAY_REDUCE_MIN: acc = _mm256_min_pd(acc, x); break;
+			case PY_ARRAY_REDUCE_MAX: acc = _mm256_max_pd(acc, x); break;
+		}
+	}
+
+	_mm256_storeu_pd(lanes, acc);
+	*res = lanes[0];
+	for(j = 1; j < 4; j++) *res = py_array_combine(r, *res, lanes[j]);
+
+	return i;
+}
+
+static PY_TARGET("sse2") unsigned py_array_dot_sse2(
+		const double* a, const double* b, unsigned n, double* res) {
+
+	unsigned i;
+	double lanes[2];
+	__m128d acc = _mm_setzero_pd();
+
+	for(i = 0; i + 2 <= n; i += 2) {
+		__m128d x = _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+		acc = _mm_add_pd(acc, x);
+	}
+
+	_mm_storeu_pd(lanes, acc);
+	*res = lanes[0] + lanes[1];
+
+	return i;
+}
+
+static PY_TARGET("avx2") unsigned py_array_dot_avx2(
+		const double* a, const double* b, unsigned n, double* res) {
+
+	unsigned i;
+	double lanes[4];
+	__m256d acc = _mm256_setzero_pd();
+
+	for(i = 0; i + 4 <= n; i += 4) {
+		__m256d x = _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+		acc = _mm256_add_pd(acc, x);
+	}
+
+	_mm256_storeu_pd(lanes, acc);
+	*res = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+	return i;
+}
+#endif
+
+static double py_array_reduce_f64(
+		enum py_array_reduction r, const double* a, unsigned n) {
+
+	unsigned i = 1;
+	double res = a[0];
+
+#ifdef PY_ARRAY_SIMD
+	switch(py_array_get_isa()) {
+		default: break;
+
+		case PY_ARRAY_ISA_AVX2: {
+			if(n >= 4) i = py_array_reduce_avx2(r, a, n, &res);
+			break;
+		}
+		case PY_ARRAY_ISA_SSE2: {
+			if(n >= 2) i = py_array_reduce_sse2(r, a, n, &res);
+			break;
+		}
+	}
+#endif
+
+	for(; i < n; i++) res = py_array_combine(r, res, a[i]);
+
+	return res;
+}
+
+struct py_object* py_array_reduce(
+		struct py_object* op, enum py_array_reduction r) {
+
+	struct py_array* ap = (void*) op;
+	unsigned i, n = ap->ob.size;
+	double res;
+
+	if(!n) {
+		if(r == PY_ARRAY_REDUCE_SUM) {
+			if(ap->kind == PY_ARRAY_INT32) return py_int_new(0);
+			return py_float_new(0.0);
+		}
+
+		py_error_set_string(py_runtime_error, "reduction of empty array");
+		return 0;
+	}
+
+	switch(ap->kind) {
+		default: {
+			res = py_array_reduce_f64(r, PY_ARRAY_FLOAT64_DATA(op), n);
+			break;
+		}
+
+		case PY_ARRAY_INT32: {
+			const py_int32_t* a = PY_ARRAY_INT32_DATA(op);
+			py_value_t v = a[0];
+
+			for(i = 1; i < n; i++) {
+				switch(r) {
+					default: v += a[i]; break;
+
+					case PY_ARRAY_REDUCE_MIN: if(a[i] < v) v = a[i]; break;
+					case PY_ARRAY_REDUCE_MAX: if(a[i] > v) v = a[i]; break;
+				}
+			}
+
+			return py_int_new(v);
+		}
+
+		case PY_ARRAY_FLOAT32: {
+			const float* a = PY_ARRAY_FLOAT32_DATA(op);
+
+			res = a[0];
+			for(i = 1; i < n; i++) res = py_array_combine(r, res, a[i]);
+
+			break;
+		}
+	}
+
+	return py_float_new(res);
+}
+
+struct py_object* py_array_dot(struct py_object* v, struct py_object* w) {
+	struct py_array* ap = (void*) v;
+	unsigned i = 0, n = ap->ob.size;
+	double res = 0.0;
+
+	if(ap->kind != ((struct py_array*) w)->kind) {
+		py_error_set_string(py_type_error, "array operands of different kinds");
+		return 0;
+	}
+
+	if(n != py_varobject_size(w)) {
+		py_error_set_string(
+				py_runtime_error, "array operands of different sizes");
+		return 0;
+	}
+
+	switch(ap->kind) {
+		default: {
+			const double* a = PY_ARRAY_FLOAT64_DATA(v);
+			const double* b = PY_ARRAY_FLOAT64_DATA(w);
+
+#ifdef PY_ARRAY_SIMD
+			switch(py_array_get_isa()) {
+				default: break;
+
+				case PY_ARRAY_ISA_AVX2: {
+					i = py_array_dot_avx2(a, b, n, &res);
+					break;
+				}
+				case PY_ARRAY_ISA_SSE2: {
+					i = py_array_dot_sse2(a, b, n, &res);
+					break;
+				}
+			}
+#endif
+
+			for(; i < n; i++) res += a[i] * b[i];
+
+			break;
+		}
+
+		case PY_ARRAY_INT32: {
+			const py_int32_t* a = PY_ARRAY_INT32_DATA(v);
+			const py_int32_t* b = PY_ARRAY_INT32_DATA(w);
+			py_value_t sum = 0;
+
+			for(; i < n; i++) sum += (py_value_t) a[i] * b[i];
+
+			return py_int_new(sum);
+		}
+
+		case PY_ARRAY_FLOAT32: {
+			const float* a = PY_ARRAY_FLOAT32_DATA(v);
+			const float* b = PY_ARRAY_FLOAT32_DATA(w);
+
+			for(; i < n; i++) res += (double) a[i] * b[i];
+
+			break;
+		}
+	}
+
+	return py_float_new(res);
+}
+
+/* Mapped functions */
+
+#ifdef PY_ARRAY_SIMD
+/*
+ * These do the functions which have vector instructions of their own over
+ * as much of a as they can, returning how many items they did.
+ */
+static PY_TARGET("sse2") unsigned py_array_map_sse2(
+		double (*func)(double), const double* a, double* out, unsigned n) {
+
+	unsigned i = 0;
+
+	if(func == sqrt) {
+		for(; i + 2 <= n; i += 2) {
+			_mm_storeu_pd(out + i, _mm_sqrt_pd(_mm_loadu_pd(a + i)));
+		}
+	}
+	else if(func == fabs) {
+		__m128d sign = _mm_set1_pd(-0.0);
+
+		for(; i + 2 <= n; i += 2) {
+			_mm_storeu_pd(out + i, _mm_andnot_pd(sign, _mm_loadu_pd(a + i)));
+		}
+	}
+
+	return i;
+}
+
+static PY_TARGET("avx2") unsigned py_array_map_avx2(
+		double (*func)(double), const double* a, double* out, unsigned n) {
+
+	unsigned i = 0;
+
+	if(func == sqrt) {
+		for(; i + 4 <= n; i += 4) {
+			_mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_loadu_pd(a + i)));
+		}
+	}
+	else if(func == fabs) {
+		__m256d sign = _mm256_set1_pd(-0.0);
+
+		for(; i + 4 <= n; i += 4) {
+			__m256d x = _mm256_loadu_pd(a + i);
+			_mm256_storeu_pd(out + i, _mm256_andnot_pd(sign, x));
+		}
+	}
+	else if(func == floor) {
+		for(; i + 4 <= n; i += 4) {
+			_mm256_storeu_pd(out + i, _mm256_floor_pd(_mm256_loadu_pd(a + i)));
+		}
+	}
+	else if(func == ceil) {
+		for(; i + 4 <= n; i += 4) {
+			_mm256_storeu_pd(out + i, _mm256_ceil_pd(_mm256_loadu_pd(a + i)));
+		}
+	}
+
+	return i;
+}
+#endif
+
+struct py_object* py_array_map(
+		struct py_object* op, double (*func)(double)) {
+
+	struct py_array* ap = (void*) op;
+	struct py_object* res;
+	unsigned i = 0, n = ap->ob.size;
+
+	if(ap->kind == PY_ARRAY_FLOAT32) {
+		const float* a = PY_ARRAY_FLOAT32_DATA(op);
+		float* out;
+
+		if(!(res = py_array_new(PY_ARRAY_FLOAT32, n))) return 0;
+		out = PY_ARRAY_FLOAT32_DATA(res);
+
+		for(; i < n; i++) out[i] = (float) func(a[i]);
+	}
+	else if(ap->kind == PY_ARRAY_INT32) {
+		const py_int32_t* a = PY_ARRAY_INT32_DATA(op);
+		double* out;
+
+		if(!(res = py_array_new(PY_ARRAY_FLOAT64, n))) return 0;
+		out = PY_ARRAY_FLOAT64_DATA(res);
+
+		for(; i < n; i++) out[i] = func(a[i]);
+	}
+	else {
+		const double* a = PY_ARRAY_FLOAT64_DATA(op);
+		double* out;
+
+		if(!(res = py_array_new(PY_ARRAY_FLOAT64, n))) return 0;
+		out = PY_ARRAY_FLOAT64_DATA(res);
+
+#ifdef PY_ARRAY_SIMD
+		switch(py_array_get_isa()) {
+			default: break;
+
+			case PY_ARRAY_ISA_AVX2: i = py_array_map_avx2(func, a, out, n); break;
+			case PY_ARRAY_ISA_SSE2: i = py_array_map_sse2(func, a, out, n); break;
+		}
+#endif
+
+		for(; i < n; i++) out[i] = func(a[i]);
+	}
+
+	return res;
+}
@@ -5,15 +5,32 @@
 
 /* Class object implementation */
 
+#include <python/std.h>
+#include <python/alloc.h>
+#include <python/errors.h>
+
 #include <python/object.h>
 #include <python/object/class.h>
 #include <python/object/dict.h>
+#include <python/object/int.h>
+
+/*
+ * The most instance attribute names a class shares out slots for. This
+ * keeps classes whose instances use attributes like a dictionary from
+ * giving every instance a huge values array.
+ */
+#define PY_CLASS_MAXKEYS (32)
 
 struct py_object* py_class_new(struct py_object* methods) {
 	struct py_class* op;
 
 	if(!(op = py_object_new(PY_TYPE_CLASS))) return 0;
 
+	if(!(op->keys = py_dict_new())) {
+		py_free(op);
+		return 0;
+	}
+
 	op->attr = py_object_incref(methods);
 
 	return (void*) op;
@@ -23,6 +40,9 @@ struct py_object* py_class_new(struct py_object* methods) {
 
 void py_class_dealloc(struct py_object* op) {
 	py_object_decref(((struct py_class*) op)->attr);
+	py_object_decref(((struct py_class*) op)->keys);
+
+	py_free(op);
 }
 
 struct py_object* py_class_get_attr(struct py_object* op, const char* name) {
@@ -43,11 +63,9 @@ struct py_object* py_class_member_new(struct py_object* class) {
 	if(!(cm = py_object_new(PY_TYPE_CLASS_MEMBER))) return 0;
 
 	cm->class = py_object_incref(class);
-
-	if(!(cm->attr = py_dict_new())) {
-		py_object_decref(cm);
-		return 0;
-	}
+	cm->attr = 0;
+	cm->values = 0;
+	cm->nvalues = 0;
 
 	return (void*) cm;
 }
@@ -56,9 +74,47 @@ struct py_object* py_class_member_new(struct py_object* class) {
 
 void py_class_member_dealloc(struct py_object* op) {
 	struct py_class_member* cm = (void*) op;
+	unsigned i;
+
+	for(i = 0; i < cm->nvalues; ++i) py_object_release(cm->values[i]);
+	if(cm->values) py_free(cm->values);
+
+	py_object_release(cm->class);
+	py_object_release(cm->attr);
+
+	py_free(op);
+}
+
+/* Give an instance a dictionary of its own, moving its values into it. */
+static int py_class_member_unshare(struct py_class_member* cm) {
+	struct py_object* key;
+	struct py_object* slot;
+	unsigned pos = 0;
+	unsigned i;
+
+	if(!(cm->attr = py_dict_new())) return -1;
+
+	while(py_dict_next(cm->class->keys, &pos, &key, &slot)) {
+		struct py_object* v;
+
+		i = (unsigned) py_int_get(slot);
+		if(i >= cm->nvalues || !(v = cm->values[i])) continue;
+
+		if(py_dict_insert_key(cm->attr, key, v) != 0) {
+			py_object_decref(cm->attr);
+			cm->attr = 0;
+
+			return -1;
+		}
+	}
+
+	for(i = 0; i < cm->nvalues; ++i) py_object_decref(cm->values[i]);
+	if(cm->values) py_free(cm->values);
 
-	py_object_decref(cm->class);
-	py_object_decref(cm->attr);
+	cm->values = 0;
+	cm->nvalues = 0;
+
+	return 0;
 }
 
 struct py_object* py_class_member_get_attr(
@@ -67,7 +123,16 @@ struct py_object* py_class_member_get_attr(
 	struct py_class_member* cm = (void*) op;
 	struct py_object* v;
 
-	if((v = py_dict_lookup(cm->attr, name))) return py_object_incref(v);
+	if(cm->attr) {
+		if((v = py_dict_lookup(cm->attr, name))) return py_object_incref(v);
+	}
+	else if(cm->nvalues && (v = py_dict_lookup(cm->class->keys, name))) {
+		unsigned i = (unsigned) py_int_get(v);
+
+		if(i < cm->nvalues && cm->values[i]) {
+			return py_object_incref(cm->values[i]);
+		}
+	}
 
 	if(!(v = py_class_get_attr((void*) cm->class, name))) return v;
 
@@ -81,6 +146,69 @@ struct py_object* py_class_member_get_attr(
 	return 0;
 }
 
+int py_class_member_set_attr(
+		struct py_object* op, struct py_object* name, struct py_object* v) {
+
+	struct py_class_member* cm = (void*) op;
+	struct py_object* keys = cm->class->keys;
+	struct py_object* slot;
+	struct py_object* old;
+	unsigned i;
+
+	if(cm->attr) {
+		if(!v) return py_dict_remove_key(cm->attr, name);
+
+		return py_dict_insert_key(cm->attr, name, v);
+	}
+
+	if(!(slot = py_dict_lookup_key(keys, name))) {
+		int err;
+
+		if(!v) return -1;
+
+		if((i = py_dict_size(keys)) >= PY_CLASS_MAXKEYS) {
+			if(py_class_member_unshare(cm) != 0) return -1;
+
+			return py_dict_insert_key(cm->attr, name, v);
+		}
+
+		if(!(slot = py_int_new((py_value_t) i))) return -1;
+
+		err = py_dict_insert_key(keys, name, slot);
+		py_object_decref(slot);
+
+		if(err != 0) return -1;
+	}
+
+	i = (unsigned) py_int_get(slot);
+
+	if(i >= cm->nvalues) {
+		unsigned n = py_dict_size(keys);
+		struct py_object** values;
+
+		if(!v) return -1;
+
+		values = py_realloc(cm->values, n * sizeof(struct py_object*));
+		if(!values) {
+			py_error_set_nomem();
+			return -1;
+		}
+
+		memset(values + cm->nvalues, 0, (n - cm->nvalues) * sizeof(*values));
+
+		cm->values = values;
+		cm->nvalues = n;
+	}
+
+	if(!v && !cm->values[i]) return -1;
+
+	old = cm->values[i];
+	cm->values[i] = py_object_incref(v);
+	py_object_decref(old);
+
+	return 0;
+}
+
 /* And finally, here are class method objects */
 /* (Really methods of class members) */
 
@@ -112,4 +240,6 @@ void py_class_method_dealloc(struct py_object* op) {
 
 	py_object_decref(cm->func);
 	py_object_decref(cm->self);
+
+	py_free(op);
 }
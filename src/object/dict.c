@@ -5,214 +5,380 @@
 
 /* Dictionary object implementation; using a hash table */
 
-/*
- * TODO: Although this may look professional, I didn't think very hard
- *       about the problem, and it is possible that obvious improvements exist.
- *       A similar module that I saw by Chris Torek:
- *        - uses chaining instead of hashed linear probing
- *        - remembers the hash value with the entry to speed up table resizing
- *        - sets the table size to a power of 2
- *        - uses a different hash function:
- *               h = 0; p = str; while (*p) h = (h<<5) - h + *p++;
- */
-
 /* TODO: Fix overly fatal EH in here. */
-/* TODO: Do dict keys need to be string *objects*? */
 
 #include <python/std.h>
+#include <python/alloc.h>
+#include <python/errors.h>
 
 #include <python/object/string.h>
+#include <python/object/tuple.h>
 #include <python/object/dict.h>
 
 /*
- * Table of primes suitable as keys, in ascending order.
- * The first line are the largest primes less than some powers of two,
- * the second line is the largest prime less than 6000,
- * and the third line is a selection from Knuth, Vol. 3, Sec. 6.1, Table 1.
- * The final value is a sentinel and should cause the memory allocation
- * of that many entries to fail (if none of the earlier values cause such
- * failure already).
+ * The items are kept densely in `entries', in insertion order, and the hash
+ * table proper (`indices') maps slots to positions in `entries'. An index
+ * slot is PY_DICT_EMPTY, PY_DICT_DUMMY (an item was removed from it) or an
+ * entry position, and is only as wide as the table size needs: a byte up
+ * to 128 slots, a short up to 32768 and a long beyond that. Entries are
+ * only allocated for the two thirds of the slots that may be filled, so a
+ * small dict takes up much less room than a table of entries would.
+ *
+ * The table size is a power of two so that probe indices are taken with a
+ * mask rather than a division, and each entry remembers the hash of its
+ * key so that neither probing nor resizing has to recompute it.
  */
 
-static unsigned primes[] = {
-		3, 7, 13, 31, 61, 127, 251, 509, 1021, 2017, 4093, 5987, 9551, 15683,
-		19609, 31397, 0xffffffff /* All bits set -- truncation OK */
-};
+#define PY_DICT_MINSIZE (8)
+
+#define PY_DICT_EMPTY (-1)
+#define PY_DICT_DUMMY (-2)
+
+/* The number of entries provided for a table of the given size. */
+#define PY_DICT_USABLE(size) (((size) * 2) / 3)
+
+/*
+ * To ensure the lookup algorithm terminates, there must be at least one
+ * empty slot in the index table. Every entry taken occupies a slot, and a
+ * removal turns the slot into a dummy rather than freeing it, so the slots
+ * in use are exactly nentries -- which is kept below two thirds of the
+ * table size. When the entries run out the table is rebuilt, at a size
+ * which only depends on used: this drops the dummies and the holes which
+ * removals leave in `entries', so a dict left mostly empty by deletions
+ * shrinks at the next insertion. (Removal itself never moves entries, so
+ * it's safe while walking the dict with py_dict_next.)
+ */
+
+static size_t py_dict_index_width(unsigned long size) {
+	if(size <= 0x80) return sizeof(signed char);
+	if(size <= 0x8000) return sizeof(short);
+
+	return sizeof(long);
+}
+
+static long py_dict_index_get(const struct py_dict* dp, unsigned long i) {
+	if(dp->mask < 0x80) return ((const signed char*) dp->indices)[i];
+	if(dp->mask < 0x8000) return ((const short*) dp->indices)[i];
+
+	return ((const long*) dp->indices)[i];
+}
 
-/* String used as dummy key to fill deleted entries */
-/* Initialized by first call to py_dict_new() */
-/* TODO: Python global state. */
-static struct py_object* dummy;
+static void py_dict_index_set(struct py_dict* dp, unsigned long i, long ix) {
+	if(dp->mask < 0x80) ((signed char*) dp->indices)[i] = (signed char) ix;
+	else if(dp->mask < 0x8000) ((short*) dp->indices)[i] = (short) ix;
+	else ((long*) dp->indices)[i] = ix;
+}
 
 /*
- * To ensure the lookup algorithm terminates, the table size must be a
- * prime number and there must be at least one NULL key in the table.
- * The value fill is the number of non-NULL keys; used is the number
- * of non-NULL, non-dummy keys.
- * To avoid slowing down lookups on a near-full table, we resize the table
- * when it is more than half filled.
+ * Give the dict a new, empty table of the given size. The entries and the
+ * indices share one block, the entries first so that both are aligned.
+ * The old table is left to the caller.
  */
+static int py_dict_alloc(struct py_dict* dp, unsigned size) {
+	unsigned usable = PY_DICT_USABLE(size);
+	size_t esize = usable * sizeof(struct py_dictentry);
+	size_t isize = size * py_dict_index_width(size);
+	char* block;
+
+	if(!(block = py_malloc(esize + isize))) return -1;
+
+	/* All bits set is PY_DICT_EMPTY at any width. */
+	memset(block + esize, 0xFF, isize);
+
+	dp->entries = (void*) block;
+	dp->indices = block + esize;
+	dp->mask = size - 1;
+	dp->usable = usable;
+	dp->nentries = 0;
+	dp->version++;
+
+	return 0;
+}
 
 struct py_object* py_dict_new(void) {
+	return py_dict_new_size(0);
+}
+
+struct py_object* py_dict_new_size(unsigned n) {
 	struct py_dict* dp;
+	unsigned size = PY_DICT_MINSIZE;
 
-	/* TODO: This really doesn't need to be here. */
-	if(!dummy) { /* Auto-initialize dummy */
-		if(!(dummy = py_string_new(""))) return 0;
+	while(PY_DICT_USABLE(size) < n) {
+		if(size > UINT_MAX / 4) return py_error_set_nomem();
+		size <<= 1;
 	}
 
 	if(!(dp = py_object_new(PY_TYPE_DICT))) return 0;
 
-	dp->size = primes[0];
+	dp->version = 0;
 
-	if(!(dp->table = calloc(dp->size, sizeof(struct py_dictentry)))) {
+	if(py_dict_alloc(dp, size) != 0) {
 		/* Free instead of decref to avoid trying to free table in dealloc. */
-		free(dp);
-		return 0;
+		py_free(dp);
+		return py_error_set_nomem();
 	}
 
-	dp->fill = 0;
 	dp->used = 0;
 
 	return (struct py_object*) dp;
 }
 
+/*
+ * A copy shares nothing with the original but the keys and values, and
+ * takes the table over as it is -- index slots, holes and all -- so no key
+ * is hashed or compared. This makes copying a template dict (as for a
+ * constant dict display) cheap.
+ */
+struct py_object* py_dict_copy(struct py_object* op) {
+	struct py_dict* dp = (struct py_dict*) op;
+	struct py_dict* np;
+	struct py_dictentry* ep;
+	unsigned size = dp->mask + 1;
+	unsigned i;
+
+	if(!(np = py_object_new(PY_TYPE_DICT))) return 0;
+
+	np->version = 0;
+
+	if(py_dict_alloc(np, size) != 0) {
+		py_free(np);
+		return py_error_set_nomem();
+	}
+
+	memcpy(np->entries, dp->entries, dp->nentries * sizeof(*ep));
+	memcpy(np->indices, dp->indices, size * py_dict_index_width(size));
+
+	np->nentries = dp->nentries;
+	np->used = dp->used;
+
+	for(i = 0, ep = np->entries; i < np->nentries; i++, ep++) {
+		if(ep->value) {
+			py_object_incref(ep->key);
+			py_object_incref(ep->value);
+		}
+	}
+
+	return (struct py_object*) np;
+}
+
 /*
  * The basic lookup function used by all operations.
- * This is essentially Algorithm D from Knuth Vol. 3, Sec. 6.4.
  * Open addressing is preferred over chaining since the link overhead for
  * chaining would be substantial (100% with typical malloc overhead).
  *
- * First a 32-bit hash value, 'sum', is computed from the key string.
- * The first character is added an extra time shifted by 8 to avoid hashing
- * single-character keys (often heavily used variables) too close together.
- * All arithmetic on sum should ignore overflow.
+ * The initial probe index is the low bits of the hash. Subsequent probes
+ * follow i = 5i + 1 + perturb (mod table size), where perturb starts out as
+ * the full hash and is shifted down each step: this lets the high bits of
+ * the hash take part, and once perturb reaches zero the recurrence visits
+ * every slot, since 5i + 1 is a full-period generator mod a power of two.
  *
- * The initial probe index is then computed as sum mod the table size.
- * Subsequent probe indices are incr apart (mod table size), where incr
- * is also derived from sum, with the additional requirement that it is
- * relative prime to the table size (i.e., 1 <= incr < size, since the size
- * is a prime number). My choice for incr is somewhat arbitrary.
+ * When the key is given as an object, an entry holding that very object
+ * matches straight away -- names are interned (see py_string_intern), so
+ * this is how most lookups succeed. Otherwise keys are only compared when
+ * their stored hashes agree: strings by their contents (the key may be
+ * given as just a char *, with keyobj NULL), other types with
+ * py_object_cmp, provided the types are the same. Returns the entry
+ * holding the key, or NULL if it isn't present; if slotp isn't NULL the
+ * index slot is stored there.
  */
 
-static struct py_dictentry* py_dict_look(struct py_dict* dp, const char* key) {
-	unsigned i, incr;
-	unsigned char* p = (unsigned char*) key;
-	unsigned long sum = *p << 7;
-
-	while(*p != '\0') sum = sum + sum + *p++;
+static struct py_dictentry* py_dict_look(
+		struct py_dict* dp, struct py_object* keyobj, const char* key,
+		unsigned len, long hash, unsigned long* slotp) {
 
-	i = sum % dp->size;
-	do {
-		sum = sum + sum + 1;
-		incr = sum % dp->size;
-	} while(incr == 0);
+	unsigned long perturb = (unsigned long) hash;
+	unsigned long i = perturb & dp->mask;
 
 	for(;;) {
-		struct py_dictentry* ep = &dp->table[i];
-		const char* str;
+		long ix = py_dict_index_get(dp, i);
 
-		if(!ep->key) return ep;
+		if(ix == PY_DICT_EMPTY) return 0;
 
-		str = py_string_get(ep->key);
+		if(ix >= 0) {
+			struct py_dictentry* ep = &dp->entries[ix];
 
-		if(!strcmp(str, key)) return ep;
+			if(ep->key == keyobj) break;
 
-		i = (i + incr) % dp->size;
+			if(ep->hash == hash) {
+				struct py_object* k = ep->key;
+
+				if(k->type == PY_TYPE_STRING) {
+					struct py_string* sp = (struct py_string*) k;
+
+					if(key && sp->ob.size == len &&
+						!memcmp(py_string_get(k), key, len)) {
+
+						break;
+					}
+				}
+				else if(keyobj && k->type == keyobj->type) {
+					if(!py_object_cmp(k, keyobj)) break;
+				}
+			}
+		}
+
+		perturb >>= 5;
+		i = (i * 5 + 1 + perturb) & dp->mask;
 	}
+
+	if(slotp) *slotp = i;
+
+	return &dp->entries[py_dict_index_get(dp, i)];
+}
+
+static struct py_dictentry* py_dict_look_string(
+		struct py_dict* dp, const char* key, unsigned long* slotp) {
+
+	unsigned long hash = PY_STRING_HASH_INIT;
+	const char* p;
+
+	for(p = key; *p; ++p) hash = PY_STRING_HASH_STEP(hash, *p);
+
+	return py_dict_look(
+			dp, 0, key, (unsigned) (p - key), PY_STRING_HASH_DONE(hash),
+			slotp);
 }
 
 /*
- * Internal routine to insert a new item into the table.
- * Used both by the internal resize routine and by the public insert routine.
- * Eats a reference to key and one to value.
+ * String objects carry their hash, so this never rehashes them. Returns -1
+ * with an error set for an unhashable key.
  */
-static void py_dict_table_insert(
-		struct py_dict* dp, struct py_object* key, struct py_object* value) {
+static long py_dict_hash(struct py_object* key) {
+	if(key->type == PY_TYPE_STRING) return py_string_hash(key);
 
-	struct py_dictentry* ep;
+	return py_object_hash(key);
+}
 
-	ep = py_dict_look(dp, py_string_get(key));
+static struct py_dictentry* py_dict_look_key(
+		struct py_dict* dp, struct py_object* key, long hash,
+		unsigned long* slotp) {
 
-	if(ep->value) {
-		py_object_decref(ep->value);
-		py_object_decref(key);
+	if(key->type == PY_TYPE_STRING) {
+		struct py_string* sp = (struct py_string*) key;
+
+		return py_dict_look(
+				dp, key, py_string_get(key), sp->ob.size, hash, slotp);
 	}
-	else {
-		if(ep->key == NULL) dp->fill++;
-		else py_object_decref(ep->key);
 
-		ep->key = key;
-		dp->used++;
+	return py_dict_look(dp, key, 0, 0, hash, slotp);
+}
+
+/*
+ * Internal routine to add an item which isn't yet in the dict, after the
+ * last entry. The caller makes sure there's an entry free.
+ * Used both by the internal resize routine and by the public insert routine.
+ * Eats a reference to key and one to value.
+ */
+static void py_dict_append(
+		struct py_dict* dp, struct py_object* key, long hash,
+		struct py_object* value) {
+
+	struct py_dictentry* ep = &dp->entries[dp->nentries];
+	unsigned long perturb = (unsigned long) hash;
+	unsigned long i = perturb & dp->mask;
+
+	while(py_dict_index_get(dp, i) != PY_DICT_EMPTY) {
+		perturb >>= 5;
+		i = (i * 5 + 1 + perturb) & dp->mask;
 	}
 
+	py_dict_index_set(dp, i, (long) dp->nentries);
+
+	ep->hash = hash;
+	ep->key = key;
 	ep->value = value;
+
+	dp->nentries++;
+	dp->used++;
 }
 
 /*
  * Restructure the table by allocating a new table and reinserting all
- * items again. When entries have been deleted, the new table may
- * actually be smaller than the old one.
+ * items again, in order. This drops all dummies and holes, so the new
+ * table may well be smaller than the old one.
  */
 static int py_dict_resize(struct py_dict* dp) {
-	unsigned oldsize = dp->size;
-	unsigned newsize;
-	struct py_dictentry* oldtable = dp->table;
-	struct py_dictentry* newtable;
+	struct py_dictentry* oldentries = dp->entries;
+	unsigned oldcount = dp->nentries;
+	unsigned newsize = PY_DICT_MINSIZE;
 	struct py_dictentry* ep;
 	unsigned i;
 
-	for(i = 0;; i++) {
-		if(primes[i] > (unsigned) (dp->used * 2)) {
-			newsize = primes[i];
-			break;
-		}
+	/* Leave the new table at most a third full. */
+	while(newsize <= dp->used * 3) {
+		if(newsize > UINT_MAX / 4) return -1;
+		newsize <<= 1;
 	}
 
-	if(!(newtable = calloc(newsize, sizeof(struct py_dictentry)))) return -1;
+	if(py_dict_alloc(dp, newsize) != 0) return -1;
 
-	dp->size = newsize;
-	dp->table = newtable;
-	dp->fill = 0;
 	dp->used = 0;
 
-	for(i = 0, ep = oldtable; i < oldsize; i++, ep++) {
-		if(ep->value) py_dict_table_insert(dp, ep->key, ep->value);
-		else if(ep->key) py_object_decref(ep->key);
+	for(i = 0, ep = oldentries; i < oldcount; i++, ep++) {
+		if(ep->value) py_dict_append(dp, ep->key, ep->hash, ep->value);
 	}
 
-	free(oldtable);
+	py_free(oldentries);
 	return 0;
 }
 
 struct py_object* py_dict_lookup(struct py_object* op, const char* key) {
-	return py_dict_look((void*) op, key)->value;
+	struct py_dictentry* ep = py_dict_look_string((void*) op, key, 0);
+
+	return ep ? ep->value : 0;
 }
 
-static int py_dict_insert_impl(
+struct py_object* py_dict_lookup_key(
+		struct py_object* op, struct py_object* key) {
+
+	struct py_dictentry* ep;
+	long hash;
+
+	if((hash = py_dict_hash(key)) == -1) return 0;
+
+	ep = py_dict_look_key((void*) op, key, hash, 0);
+
+	return ep ? ep->value : 0;
+}
+
+int py_dict_insert_key(
 		struct py_object* op, struct py_object* key, struct py_object* value) {
 
 	struct py_dict* dp;
-	struct py_object* keyobj;
+	struct py_dictentry* ep;
+	long hash;
 
 	/* TODO: Non-typechecked builds. */
 	if(op->type != PY_TYPE_DICT) return -1;
 
 	dp = (struct py_dict*) op;
-	if(key->type != PY_TYPE_STRING) return -1;
+	if((hash = py_dict_hash(key)) == -1) return -1;
+
+	if((ep = py_dict_look_key(dp, key, hash, 0))) {
+		struct py_object* old = ep->value;
+
+		ep->value = py_object_incref(value);
+		py_object_decref(old);
 
-	keyobj = key;
+		return 0;
+	}
 
-	/* if fill >= 2/3 size, resize */
-	if(dp->fill * 3 >= dp->size * 2) {
-		if(py_dict_resize(dp) != 0) {
-			if(dp->fill + 1 > dp->size) return -1;
+	/*
+	 * Rebuild the table if the entries have run out. Likewise if deletions
+	 * have left less than 1/8 in use, which shrinks the table. (A table
+	 * without deletions may just have been made large up front.)
+	 */
+	if(dp->nentries == dp->usable || (dp->nentries != dp->used &&
+		dp->mask >= PY_DICT_MINSIZE && dp->used * 8 < dp->mask)) {
+
+		if(py_dict_resize(dp) != 0 && dp->nentries == dp->usable) {
+			py_error_set_nomem();
+			return -1;
 		}
 	}
 
-	py_object_incref(keyobj);
-	py_object_incref(value);
-	py_dict_table_insert(dp, keyobj, value);
+	py_dict_append(
+			dp, py_object_incref(key), hash, py_object_incref(value));
 
 	return 0;
 }
@@ -223,42 +389,102 @@ int py_dict_insert(
 	struct py_object* keyobj;
 	int err;
 
-	if(!(keyobj = py_string_new(key))) return -1;
+	if(!(keyobj = py_string_intern(key))) return -1;
 
-	err = py_dict_insert_impl(op, keyobj, value);
+	err = py_dict_insert_key(op, keyobj, value);
 	py_object_decref(keyobj);
 
 	return err;
 }
 
-int py_dict_remove(struct py_object* op, const char* key) {
-	struct py_dict* dp;
-	struct py_dictentry* ep;
-
-	dp = (struct py_dict*) op;
-	ep = py_dict_look(dp, key);
+/*
+ * Take the item out of its entry, leaving a hole, and mark its index slot
+ * as a dummy. The entry is cleared before the references are dropped, so
+ * the dict is consistent if that runs arbitrary deallocation code.
+ */
+static int py_dict_remove_entry(
+		struct py_dict* dp, struct py_dictentry* ep, unsigned long slot) {
 
-	if(!ep->value) return -1;
+	struct py_object* key;
+	struct py_object* value;
 
-	py_object_decref(ep->key);
+	if(!ep) return -1;
 
-	ep->key = py_object_incref(dummy);
+	py_dict_index_set(dp, slot, PY_DICT_DUMMY);
 
-	py_object_decref(ep->value);
+	key = ep->key;
+	value = ep->value;
 
+	ep->key = 0;
 	ep->value = 0;
 	dp->used--;
+	dp->version++;
+
+	py_object_decref(key);
+	py_object_decref(value);
 
 	return 0;
 }
 
-static int py_dict_remove_impl(struct py_object* op, struct py_object* key) {
-	return py_dict_remove(op, py_string_get(key));
+int py_dict_remove(struct py_object* op, const char* key) {
+	struct py_dict* dp = (struct py_dict*) op;
+	unsigned long slot = 0;
+	struct py_dictentry* ep = py_dict_look_string(dp, key, &slot);
+
+	return py_dict_remove_entry(dp, ep, slot);
+}
+
+int py_dict_remove_key(struct py_object* op, struct py_object* key) {
+	struct py_dict* dp = (struct py_dict*) op;
+	unsigned long slot = 0;
+	struct py_dictentry* ep;
+	long hash;
+
+	if((hash = py_dict_hash(key)) == -1) return -1;
+
+	ep = py_dict_look_key(dp, key, hash, &slot);
+
+	return py_dict_remove_entry(dp, ep, slot);
+}
+
+void py_dict_clear(struct py_object* op) {
+	struct py_dict* dp = (struct py_dict*) op;
+	unsigned i;
+
+	/*
+	 * Removal leaves everything else in place, so this works whatever the
+	 * deallocation of the values does to the dict.
+	 */
+	for(i = 0; i < dp->nentries; ++i) {
+		struct py_dictentry* ep = &dp->entries[i];
+
+		if(ep->value) (void) py_dict_remove_key(op, ep->key);
+	}
+}
+
+int py_dict_next(
+		struct py_object* op, unsigned* pos, struct py_object** key,
+		struct py_object** value) {
+
+	struct py_dict* dp = (struct py_dict*) op;
+
+	while(*pos < dp->nentries) {
+		struct py_dictentry* ep = &dp->entries[(*pos)++];
+
+		if(ep->value) {
+			if(key) *key = ep->key;
+			if(value) *value = ep->value;
+
+			return 1;
+		}
+	}
+
+	return 0;
 }
 
 /* TODO: Dicts as varobjects? */
 unsigned py_dict_size(struct py_object* op) {
-	return ((struct py_dict*) op)->size;
+	return ((struct py_dict*) op)->used;
 }
 
 static struct py_object* py_dict_get_key_impl(
@@ -266,53 +492,157 @@ static struct py_object* py_dict_get_key_impl(
 
 	struct py_dict* dp = (void*) op;
 
-	/* Not an error! */
-	if(!dp->table[i].value) return 0;
+	if(i >= dp->used) return 0;
+
+	/*
+	 * Close up any holes left by removals so that the entries can be
+	 * indexed directly. Should that fail, count through them instead.
+	 */
+	if(dp->nentries != dp->used && py_dict_resize(dp) != 0) {
+		unsigned pos = 0;
+		struct py_object* key = 0;
 
-	return (void*) dp->table[i].key;
+		do (void) py_dict_next(op, &pos, &key, 0); while(i--);
+
+		return key;
+	}
+
+	return dp->entries[i].key;
 }
 
 const char* py_dict_get_key(struct py_object* op, unsigned i) {
 	struct py_object* key;
 
 	if(!(key = py_dict_get_key_impl(op, i))) return 0;
+	if(key->type != PY_TYPE_STRING) return 0;
 
 	return py_string_get(key);
 }
 
 /* Methods */
 
+int py_dict_truthy(struct py_object* op) {
+	return ((struct py_dict*) op)->used != 0;
+}
+
 void py_dict_dealloc(struct py_object* op) {
 	struct py_dict* dp = (struct py_dict*) op;
 	struct py_dictentry* ep;
 	unsigned i;
 
-	for(i = 0, ep = dp->table; i < dp->size; i++, ep++) {
-		if(ep->key) py_object_decref(ep->key);
-		if(ep->value) py_object_decref(ep->value);
+	for(i = 0, ep = dp->entries; i < dp->nentries; i++, ep++) {
+		if(ep->value) {
+			py_object_release(ep->key);
+			py_object_release(ep->value);
+		}
 	}
 
-	if(dp->table) free(dp->table);
+	if(dp->entries) py_free(dp->entries);
+
+	py_free(op);
 }
 
 struct py_object* py_dict_lookup_object(
 		struct py_object* dp, struct py_object* v) {
 
-	if(!(v = py_dict_look((struct py_dict*) dp, py_string_get(v))->value)) {
-		return 0;
-	}
+	struct py_dictentry* ep;
+	long hash;
+
+	if((hash = py_dict_hash(v)) == -1) return 0;
 
-	return py_object_incref(v);
+	if(!(ep = py_dict_look_key((struct py_dict*) dp, v, hash, 0))) return 0;
+
+	return py_object_incref(ep->value);
 }
 
 int py_dict_assign(
 		struct py_object* dp, struct py_object* v, struct py_object* w) {
 
-	if(!w) return py_dict_remove_impl((void*) dp, v);
+	if(!w) return py_dict_remove_key((void*) dp, v);
+
+	return py_dict_insert_key((void*) dp, v, w);
+}
+
+/* Dict views */
+
+struct py_object* py_dict_view_new(
+		struct py_object* op, enum py_dict_view_kind kind) {
+
+	struct py_dict_view* vp;
+
+	if(!(vp = py_object_new(PY_TYPE_DICT_VIEW))) return 0;
+
+	vp->dict = py_object_incref(op);
+	vp->kind = kind;
+	vp->index = 0;
+	vp->pos = 0;
+	vp->version = vp->dict->version;
+
+	return (struct py_object*) vp;
+}
+
+unsigned py_dict_view_size(struct py_object* op) {
+	return ((struct py_dict_view*) op)->dict->used;
+}
+
+static struct py_dictentry* py_dict_view_entry(
+		struct py_dict_view* vp, unsigned i) {
+
+	struct py_dict* dp = vp->dict;
+
+	if(i >= dp->used) return 0;
 
-	return py_dict_insert_impl((void*) dp, v, w);
+	/* Without holes, the entries are indexed directly. */
+	if(dp->nentries == dp->used) return &dp->entries[i];
+
+	if(vp->version != dp->version || i < vp->index) {
+		vp->index = 0;
+		vp->pos = 0;
+		vp->version = dp->version;
+	}
+
+	/* There are more than i items, so this finds one. */
+	for(;; vp->pos++) {
+		struct py_dictentry* ep = &dp->entries[vp->pos];
+
+		if(!ep->value) continue;
+		if(vp->index == i) return ep;
+
+		vp->index++;
+	}
 }
 
-void py_done_dict(void) {
-	py_object_decref(dummy);
+struct py_object* py_dict_view_ind(struct py_object* op, unsigned i) {
+	struct py_dict_view* vp = (struct py_dict_view*) op;
+	struct py_dictentry* ep;
+	struct py_object* item;
+
+	if(!(ep = py_dict_view_entry(vp, i))) {
+		py_error_set_string(py_runtime_error, "dict view index out of range");
+		return 0;
+	}
+
+	switch(vp->kind) {
+		default: break;
+
+		case PY_DICT_VIEW_KEYS: return py_object_incref(ep->key);
+		case PY_DICT_VIEW_VALUES: return py_object_incref(ep->value);
+	}
+
+	if(!(item = py_tuple_new(2))) return 0;
+
+	py_tuple_set(item, 0, py_object_incref(ep->key));
+	py_tuple_set(item, 1, py_object_incref(ep->value));
+
+	return item;
+}
+
+int py_dict_view_truthy(struct py_object* op) {
+	return ((struct py_dict_view*) op)->dict->used != 0;
+}
+
+void py_dict_view_dealloc(struct py_object* op) {
+	py_object_decref(((struct py_dict_view*) op)->dict);
+
+	py_free(op);
 }
@@ -5,15 +5,67 @@
 
 /* Float object implementation */
 
+#include <python/std.h>
+#include <python/alloc.h>
+#include <python/errors.h>
+
 #include <python/object/float.h>
+#include <python/object/int.h>
+
+/*
+ * Floats are allocated the same way as integers (see int.c): most
+ * arithmetic on floats produces a fresh temporary which is dropped again
+ * shortly after, so they come from a dedicated free list which is filled
+ * a block at a time from malloc() rather than from malloc() one by one.
+ * Blocks are never returned to the system.
+ */
+
+#define PY_FLOAT_BLOCK_SIZE (1024) /* 1K less typical malloc overhead */
+#define PY_FLOAT_COUNT (PY_FLOAT_BLOCK_SIZE / sizeof(struct py_float))
+
+/* TODO: Python global state. */
+static struct py_float* py_float_freelist = NULL;
+static struct py_alloc_stats py_float_stats;
+
+static enum py_result py_float_freelist_fill(void) {
+	struct py_float* p;
+	struct py_float* q;
+
+	if(!(p = py_calloc(PY_FLOAT_COUNT, sizeof(struct py_float)))) {
+		return PY_RESULT_OOM;
+	}
+
+	q = p + PY_FLOAT_COUNT;
+
+	while(--q > p) *(struct py_float**) q = q - 1;
+
+	*(struct py_float**) q = 0;
+
+	py_float_freelist = p + PY_FLOAT_COUNT - 1;
+
+	py_float_stats.blocks++;
+	py_float_stats.free += PY_FLOAT_COUNT;
+
+	return PY_RESULT_OK;
+}
 
 struct py_object* py_float_new(double value) {
 	struct py_float* op;
 
-	if(!(op = py_object_new(PY_TYPE_FLOAT))) return 0;
+	if(!py_float_freelist && (py_float_freelist_fill() != PY_RESULT_OK)) {
+		return py_error_set_nomem();
+	}
 
+	op = py_float_freelist;
+	py_float_freelist = *(struct py_float**) py_float_freelist;
+	py_object_newref(op);
+
+	op->ob.type = PY_TYPE_FLOAT;
 	op->value = value;
 
+	py_float_stats.allocs++;
+	py_float_stats.free--;
+
 	return (void*) op;
 }
 
@@ -21,11 +73,113 @@ double py_float_get(const struct py_object* op) {
 	return ((struct py_float*) op)->value;
 }
 
+void py_float_get_stats(struct py_alloc_stats* stats) {
+	*stats = py_float_stats;
+}
+
 /* Methods */
 
+void py_float_dealloc(struct py_object* op) {
+	*(struct py_float**) op = py_float_freelist;
+	py_float_freelist = (void*) op;
+
+	py_float_stats.frees++;
+	py_float_stats.free++;
+}
+
 int py_float_cmp(const struct py_object* v, const struct py_object* w) {
 	double i = py_float_get(v);
 	double j = py_float_get(w);
 
 	return (i < j) ? -1 : (i > j) ? 1 : 0;
 }
+
+int py_float_truthy(struct py_object* op) {
+	return py_float_get(op) != 0.0;
+}
+
+long py_float_hash(struct py_object* op) {
+	double v = py_float_get(op);
+	double hi;
+	long hash;
+	int e;
+
+	if(v - v != 0.0) return 0; /* Infinities and NaN */
+
+	/* Fold the mantissa into two halves and add the exponent in. */
+	v = frexp(v, &e) * 2147483648.0;
+	hi = floor(v);
+	v = (v - hi) * 2147483648.0;
+
+	hash = (long) hi + (long) v + (long) e * 32768L;
+
+	return hash == -1 ? -2 : hash;
+}
+
+/*
+ * The binary methods also serve mixed int and float operands, which
+ * py_types_register enters into py_binary_ops alongside float and float.
+ */
+static double py_float_value(const struct py_object* op) {
+	if(op->type == PY_TYPE_INT) return (double) py_int_get(op);
+
+	return py_float_get(op);
+}
+
+static struct py_object* py_float_add(
+		struct py_object* v, struct py_object* w) {
+
+	return py_float_new(py_float_value(v) + py_float_value(w));
+}
+
+static struct py_object* py_float_sub(
+		struct py_object* v, struct py_object* w) {
+
+	return py_float_new(py_float_value(v) - py_float_value(w));
+}
+
+static struct py_object* py_float_mul(
+		struct py_object* v, struct py_object* w) {
+
+	return py_float_new(py_float_value(v) * py_float_value(w));
+}
+
+static struct py_object* py_float_div(
+		struct py_object* v, struct py_object* w) {
+
+	return py_float_new(py_float_value(v) / py_float_value(w));
+}
+
+static struct py_object* py_float_mod(
+		struct py_object* v, struct py_object* w) {
+
+	return py_float_new(fmod(py_float_value(v), py_float_value(w)));
+}
+
+static struct py_object* py_float_neg(struct py_object* v) {
+	return py_float_new(-py_float_get(v));
+}
+
+const struct py_number_methods py_float_number = {
+		py_float_add, py_float_sub, py_float_mul, py_float_div, py_float_mod,
+		py_float_neg
+};
+
+void py_float_update(
+		enum py_binary_op op, struct py_object* v, const struct py_object* w) {
+
+	double a = py_float_get(v);
+	double b = py_float_value(w);
+
+	switch(op) {
+		default: break;
+
+		case PY_BINARY_ADD: a += b; break;
+		case PY_BINARY_SUB: a -= b; break;
+		case PY_BINARY_MUL: a *= b; break;
+		case PY_BINARY_DIV: a /= b; break;
+		case PY_BINARY_MOD: a = fmod(a, b); break;
+	}
+
+	((struct py_float*) v)->value = a;
+}
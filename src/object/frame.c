@@ -6,6 +6,7 @@
 /* Frame object implementation */
 
 #include <python/std.h>
+#include <python/alloc.h>
 #include <python/compile.h>
 #include <python/opcode.h>
 
@@ -24,12 +25,14 @@ struct py_frame* py_frame_new(
 	f->code = py_object_incref(code);
 	f->globals = py_object_incref(globals);
 	f->locals = py_object_incref(locals);
+	f->valuestack = 0;
+	f->blockstack = 0;
 
-	if(!(f->valuestack = calloc(nvalues + 1, sizeof(struct py_object*)))) {
+	if(!(f->valuestack = py_calloc(nvalues + 1, sizeof(struct py_object*)))) {
 		goto cleanup;
 	}
 
-	if(!(f->blockstack = calloc(nblocks + 1, sizeof(struct py_block)))) {
+	if(!(f->blockstack = py_calloc(nblocks + 1, sizeof(struct py_block)))) {
 		goto cleanup;
 	}
 
@@ -69,6 +72,8 @@ void py_frame_dealloc(struct py_object* op) {
 	py_object_decref(f->globals);
 	py_object_decref(f->locals);
 
-	free(f->valuestack);
-	free(f->blockstack);
+	py_free(f->valuestack);
+	py_free(f->blockstack);
+
+	py_free(op);
 }
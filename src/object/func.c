@@ -6,6 +6,7 @@
 /* Function object implementation */
 
 #include <python/std.h>
+#include <python/alloc.h>
 
 #include <python/object.h>
 #include <python/object/func.h>
@@ -29,5 +30,5 @@ void py_func_dealloc(struct py_object* op) {
 	py_object_decref(fp->code);
 	py_object_decref(fp->globals);
 
-	free(op);
+	py_free(op);
 }
@@ -6,6 +6,8 @@
 /* Integer object implementation */
 
 #include <python/std.h>
+#include <python/alloc.h>
+#include <python/errors.h>
 
 #include <python/object/int.h>
 #include <python/object/string.h>
@@ -31,12 +33,13 @@ struct py_int py_false_object = { { PY_TYPE_INT, 1 }, 0 };
 
 /* TODO: Python global state. */
 static struct py_int* py_int_freelist = NULL;
+static struct py_alloc_stats py_int_stats;
 
 static enum py_result py_int_freelist_fill(void) {
 	struct py_int* p;
 	struct py_int* q;
 
-	if(!(p = calloc(PY_INT_COUNT, sizeof(struct py_int)))) {
+	if(!(p = py_calloc(PY_INT_COUNT, sizeof(struct py_int)))) {
 		return PY_RESULT_OOM;
 	}
 
@@ -48,13 +51,18 @@ static enum py_result py_int_freelist_fill(void) {
 
 	py_int_freelist = p + PY_INT_COUNT - 1;
 
+	py_int_stats.blocks++;
+	py_int_stats.free += PY_INT_COUNT;
+
 	return PY_RESULT_OK;
 }
 
 struct py_object* py_int_new(py_value_t value) {
 	struct py_int* v;
 
-	if(!py_int_freelist && (py_int_freelist_fill() != PY_RESULT_OK)) return 0;
+	if(!py_int_freelist && (py_int_freelist_fill() != PY_RESULT_OK)) {
+		return py_error_set_nomem();
+	}
 
 	v = py_int_freelist;
 	py_int_freelist = *(struct py_int**) py_int_freelist;
@@ -63,18 +71,28 @@ struct py_object* py_int_new(py_value_t value) {
 	v->ob.type = PY_TYPE_INT;
 	v->value = value;
 
+	py_int_stats.allocs++;
+	py_int_stats.free--;
+
 	return (void*) v;
 }
 
 void py_int_dealloc(struct py_object* v) {
 	*(struct py_int**) v = py_int_freelist;
 	py_int_freelist = (void*) v;
+
+	py_int_stats.frees++;
+	py_int_stats.free++;
 }
 
 py_value_t py_int_get(const struct py_object* op) {
 	return ((struct py_int*) op)->value;
 }
 
+void py_int_get_stats(struct py_alloc_stats* stats) {
+	*stats = py_int_stats;
+}
+
 /* Methods */
 
 int py_int_cmp(const struct py_object* v, const struct py_object* w) {
@@ -83,3 +101,71 @@ int py_int_cmp(const struct py_object* v, const struct py_object* w) {
 
 	return (i < j) ? -1 : (i > j) ? 1 : 0;
 }
+
+int py_int_truthy(struct py_object* op) {
+	return py_int_get(op) != 0;
+}
+
+long py_int_hash(struct py_object* op) {
+	long hash = (long) py_int_get(op);
+
+	return hash == -1 ? -2 : hash;
+}
+
+static struct py_object* py_int_add(struct py_object* v, struct py_object* w) {
+	return py_int_new(py_int_get(v) + py_int_get(w));
+}
+
+static struct py_object* py_int_sub(struct py_object* v, struct py_object* w) {
+	return py_int_new(py_int_get(v) - py_int_get(w));
+}
+
+static struct py_object* py_int_mul(struct py_object* v, struct py_object* w) {
+	return py_int_new(py_int_get(v) * py_int_get(w));
+}
+
+static struct py_object* py_int_div(struct py_object* v, struct py_object* w) {
+	if(py_int_get(w) == 0) {
+		py_error_set_string(py_runtime_error, "integer division by zero");
+		return 0;
+	}
+
+	return py_int_new(py_int_get(v) / py_int_get(w));
+}
+
+static struct py_object* py_int_mod(struct py_object* v, struct py_object* w) {
+	if(py_int_get(w) == 0) {
+		py_error_set_string(py_runtime_error, "integer modulo by zero");
+		return 0;
+	}
+
+	return py_int_new(py_int_get(v) % py_int_get(w));
+}
+
+static struct py_object* py_int_neg(struct py_object* v) {
+	return py_int_new(-py_int_get(v));
+}
+
+const struct py_number_methods py_int_number = {
+		py_int_add, py_int_sub, py_int_mul, py_int_div, py_int_mod,
+		py_int_neg
+};
+
+void py_int_update(
+		enum py_binary_op op, struct py_object* v, const struct py_object* w) {
+
+	py_value_t a = py_int_get(v);
+	py_value_t b = py_int_get(w);
+
+	switch(op) {
+		default: break;
+
+		case PY_BINARY_ADD: a += b; break;
+		case PY_BINARY_SUB: a -= b; break;
+		case PY_BINARY_MUL: a *= b; break;
+		case PY_BINARY_DIV: a /= b; break;
+		case PY_BINARY_MOD: a %= b; break;
+	}
+
+	((struct py_int*) v)->value = a;
+}
@@ -6,8 +6,14 @@
 /* List object implementation */
 
 #include <python/std.h>
+#include <python/alloc.h>
+#include <python/errors.h>
 
 #include <python/object/list.h>
+#include <python/object/tuple.h>
+#include <python/object/int.h>
+#include <python/object/float.h>
+#include <python/object/string.h>
 
 struct py_object* py_list_new(unsigned size) {
 	struct py_list* op;
@@ -15,11 +21,13 @@ struct py_object* py_list_new(unsigned size) {
 	if(!(op = py_object_new(PY_TYPE_LIST))) return 0;
 	op->ob.size = size;
 
-	if(!(op->item = calloc(size, sizeof(struct py_object*)))) {
-		free(op);
-		return 0;
+	if(!(op->item = py_calloc(size, sizeof(struct py_object*)))) {
+		py_free(op);
+		return py_error_set_nomem();
 	}
 
+	op->allocated = size;
+
 	return (void*) op;
 }
 
@@ -37,14 +45,37 @@ void py_list_set(struct py_object* op, unsigned i, struct py_object* item) {
 	py_object_decref(old);
 }
 
+/*
+ * Make room for at least `size' items. The growth pattern is roughly 1.125x
+ * plus a little: 0, 4, 8, 16, 25, 35, 46, 58, 72, 88, ...
+ */
+static int py_list_reserve(struct py_list* self, unsigned size) {
+	struct py_object** items;
+	unsigned allocated;
+
+	if(size <= self->allocated) return 0;
+
+	allocated = size + (size >> 3) + (size < 9 ? 3 : 6);
+	if(allocated < size) return -1;
+
+	/* This isn't leaky -- we want to preserve original in OOM case here. */
+	items = py_realloc(self->item, allocated * sizeof(struct py_object*));
+	if(!items) return -1;
+
+	self->item = items;
+	self->allocated = allocated;
+
+	return 0;
+}
+
 static int py_list_insert_impl(
 		struct py_list* self, unsigned where, struct py_object* v) {
 
 	struct py_object** items;
 
-	/* This isn't leaky -- we want to preserve original in OOM case here. */
-	items = realloc(self->item, (self->ob.size + 1) * sizeof(struct py_object*));
-	if(!items) return -1;
+	if(py_list_reserve(self, self->ob.size + 1) != 0) return -1;
+
+	items = self->item;
 
 	if(where > self->ob.size) where = self->ob.size;
 
@@ -54,7 +85,6 @@ static int py_list_insert_impl(
 
 	items[where] = py_object_incref(v);
 
-	self->item = items;
 	self->ob.size++;
 
 	return 0;
@@ -67,7 +97,305 @@ int py_list_insert(
 }
 
 int py_list_add(struct py_object* op, struct py_object* item) {
-	return py_list_insert_impl((void*) op, py_varobject_size(op), item);
+	struct py_list* lp = (void*) op;
+
+	if(lp->ob.size < lp->allocated) {
+		lp->item[lp->ob.size++] = py_object_incref(item);
+		return 0;
+	}
+
+	return py_list_insert_impl(lp, lp->ob.size, item);
+}
+
+int py_list_set_slice(
+		struct py_object* op, unsigned low, unsigned high,
+		struct py_object* v) {
+
+	struct py_list* lp = (void*) op;
+	struct py_object** src = 0;
+	struct py_object** old = 0;
+	struct py_object* copy = 0;
+	unsigned size = lp->ob.size;
+	unsigned n = 0, d, i;
+
+	if(low > size) low = size;
+
+	if(high < low) high = low;
+	else if(high > size) high = size;
+
+	d = high - low;
+
+	if(v) {
+		if(v == op) {
+			/* The source would move under our feet, so copy it first. */
+			if(!(v = copy = py_list_slice(op, 0, size))) return -1;
+		}
+
+		if(v->type == PY_TYPE_LIST) src = ((struct py_list*) v)->item;
+		else if(v->type == PY_TYPE_TUPLE) src = ((struct py_tuple*) v)->item;
+		else {
+			py_error_set_badarg();
+			return -1;
+		}
+
+		n = py_varobject_size(v);
+	}
+
+	/*
+	 * The items replaced are only released once the list is whole again,
+	 * as that may run arbitrary deallocation code.
+	 */
+	if(d && !(old = py_malloc(d * sizeof(struct py_object*)))) {
+		py_object_decref(copy);
+		py_error_set_nomem();
+		return -1;
+	}
+
+	if(n > d && py_list_reserve(lp, size - d + n) != 0) {
+		if(old) py_free(old);
+		py_object_decref(copy);
+		py_error_set_nomem();
+		return -1;
+	}
+
+	if(d) memcpy(old, &lp->item[low], d * sizeof(struct py_object*));
+
+	memmove(
+			&lp->item[low + n], &lp->item[high],
+			(size - high) * sizeof(struct py_object*));
+
+	for(i = 0; i < n; i++) lp->item[low + i] = py_object_incref(src[i]);
+
+	lp->ob.size = size - d + n;
+
+	for(i = 0; i < d; i++) py_object_decref(old[i]);
+	if(old) py_free(old);
+
+	py_object_decref(copy);
+
+	return 0;
+}
+
+int py_list_extend(struct py_object* op, struct py_object* v) {
+	unsigned size = py_varobject_size(op);
+
+	return py_list_set_slice(op, size, size, v);
+}
+
+struct py_object* py_list_pop(struct py_object* op, unsigned i) {
+	struct py_list* lp = (void*) op;
+	struct py_object* item;
+
+	if(i >= lp->ob.size) {
+		py_error_set_string(py_runtime_error, "list index out of range");
+		return 0;
+	}
+
+	item = lp->item[i];
+
+	memmove(
+			&lp->item[i], &lp->item[i + 1],
+			(lp->ob.size - i - 1) * sizeof(struct py_object*));
+
+	lp->ob.size--;
+
+	return item;
+}
+
+long py_list_index(const struct py_object* op, const struct py_object* v) {
+	const struct py_list* lp = (const void*) op;
+	unsigned i;
+
+	for(i = 0; i < lp->ob.size; i++) {
+		if(lp->item[i] == v || !py_object_cmp(lp->item[i], v)) return (long) i;
+	}
+
+	return -1;
+}
+
+/*
+ * Sorting is a natural merge sort. The list is cut into runs which are
+ * already in order (strictly descending ones are reversed), short runs
+ * being made up to PY_SORT_MINRUN items by binary insertion; then
+ * neighbouring runs are merged pairwise until one is left. Input which is
+ * already (nearly) sorted thus takes little more than a pass.
+ * The comparison is picked once per sort: when all the keys are ints,
+ * floats or strings, the type's compare method is called directly.
+ */
+
+#define PY_SORT_MINRUN (32)
+
+struct py_sortitem {
+	struct py_object* key;
+	struct py_object* value;
+};
+
+typedef int (*py_sort_cmp_t)(const struct py_object*, const struct py_object*);
+
+static py_sort_cmp_t py_sort_cmp_for(
+		const struct py_sortitem* items, unsigned n) {
+
+	enum py_type type = items[0].key->type;
+	unsigned i;
+
+	for(i = 1; i < n; i++) {
+		if(items[i].key->type != type) return py_object_cmp;
+	}
+
+	switch(type) {
+		default: return py_object_cmp;
+
+		case PY_TYPE_INT: return py_int_cmp;
+		case PY_TYPE_FLOAT: return py_float_cmp;
+		case PY_TYPE_STRING: return py_string_cmp;
+	}
+}
+
+/* Sort lo[0..n) by binary insertion, given lo[0..sorted) is in order. */
+static void py_sort_insertion(
+		struct py_sortitem* lo, unsigned n, unsigned sorted,
+		py_sort_cmp_t cmp) {
+
+	unsigned i;
+
+	for(i = sorted ? sorted : 1; i < n; i++) {
+		struct py_sortitem pivot = lo[i];
+		unsigned l = 0, r = i;
+
+		/* Equal keys go after the ones already placed, for stability. */
+		while(l < r) {
+			unsigned m = l + (r - l) / 2;
+
+			if(cmp(pivot.key, lo[m].key) < 0) r = m;
+			else l = m + 1;
+		}
+
+		memmove(&lo[l + 1], &lo[l], (i - l) * sizeof(*lo));
+		lo[l] = pivot;
+	}
+}
+
+/* The length of the run starting at lo, which is left ascending. */
+static unsigned py_sort_count_run(
+		struct py_sortitem* lo, unsigned n, py_sort_cmp_t cmp) {
+
+	unsigned i, j;
+
+	if(n < 2) return n;
+
+	if(cmp(lo[1].key, lo[0].key) < 0) {
+		for(i = 2; i < n && cmp(lo[i].key, lo[i - 1].key) < 0; i++) continue;
+
+		for(j = 0; j < i / 2; j++) {
+			struct py_sortitem t = lo[j];
+
+			lo[j] = lo[i - 1 - j];
+			lo[i - 1 - j] = t;
+		}
+	}
+	else {
+		for(i = 2; i < n && cmp(lo[i].key, lo[i - 1].key) >= 0; i++) continue;
+	}
+
+	return i;
+}
+
+/* Merge the neighbouring runs a[0..na) and a[na..na+nb), using tmp. */
+static void py_sort_merge(
+		struct py_sortitem* a, unsigned na, unsigned nb,
+		struct py_sortitem* tmp, py_sort_cmp_t cmp) {
+
+	struct py_sortitem* b = a + na;
+	struct py_sortitem* end = b + nb;
+	struct py_sortitem* l = tmp;
+	struct py_sortitem* lend = tmp + na;
+
+	if(cmp(b[0].key, b[-1].key) >= 0) return; /* Already in order */
+
+	memcpy(tmp, a, na * sizeof(*a));
+
+	while(l < lend && b < end) {
+		if(cmp(b->key, l->key) < 0) *a++ = *b++;
+		else *a++ = *l++;
+	}
+
+	/* Whatever is left of the right run is in place already. */
+	while(l < lend) *a++ = *l++;
+}
+
+int py_list_sort(struct py_object* op, struct py_object** keys) {
+	struct py_list* lp = (void*) op;
+	unsigned n = lp->ob.size;
+	struct py_sortitem* items;
+	struct py_sortitem* tmp;
+	unsigned* runs;
+	unsigned nruns, i, j;
+	py_sort_cmp_t cmp;
+
+	if(n < 2) return 0;
+
+	items = py_malloc(n * sizeof(struct py_sortitem));
+	tmp = py_malloc(n * sizeof(struct py_sortitem));
+
+	/* Runs but the last have at least PY_SORT_MINRUN items. */
+	runs = py_malloc((n / PY_SORT_MINRUN + 2) * sizeof(unsigned));
+
+	if(!items || !tmp || !runs) {
+		if(items) py_free(items);
+		if(tmp) py_free(tmp);
+		if(runs) py_free(runs);
+
+		py_error_set_nomem();
+		return -1;
+	}
+
+	for(i = 0; i < n; i++) {
+		items[i].key = keys ? keys[i] : lp->item[i];
+		items[i].value = lp->item[i];
+	}
+
+	cmp = py_sort_cmp_for(items, n);
+
+	/* Cut into runs; runs[i] is where run i starts. */
+	for(i = 0, nruns = 0; i < n; i += j) {
+		unsigned left = n - i;
+
+		j = py_sort_count_run(&items[i], left, cmp);
+
+		if(j < PY_SORT_MINRUN && j < left) {
+			unsigned want = left < PY_SORT_MINRUN ? left : PY_SORT_MINRUN;
+
+			py_sort_insertion(&items[i], want, j, cmp);
+			j = want;
+		}
+
+		runs[nruns++] = i;
+	}
+
+	/* Merge pairs of runs until only one is left. */
+	while(nruns > 1) {
+		runs[nruns] = n;
+
+		for(i = 0, j = 0; i + 1 < nruns; i += 2, j++) {
+			unsigned na = runs[i + 1] - runs[i];
+			unsigned nb = runs[i + 2] - runs[i + 1];
+
+			py_sort_merge(&items[runs[i]], na, nb, tmp, cmp);
+			runs[j] = runs[i];
+		}
+
+		if(i < nruns) runs[j++] = runs[i];
+
+		nruns = j;
+	}
+
+	for(i = 0; i < n; i++) lp->item[i] = items[i].value;
+
+	py_free(items);
+	py_free(tmp);
+	py_free(runs);
+
+	return 0;
 }
 
 /* Methods */
@@ -75,9 +403,11 @@ void py_list_dealloc(struct py_object* op) {
 	unsigned i;
 	struct py_list* lp = (void*) op;
 
-	for(i = 0; i < lp->ob.size; i++) py_object_decref(lp->item[i]);
+	for(i = 0; i < lp->ob.size; i++) py_object_release(lp->item[i]);
+
+	py_free(lp->item);
 
-	free(lp->item);
+	py_free(op);
 }
 
 int py_list_cmp(const struct py_object* v, const struct py_object* w) {
@@ -112,6 +442,7 @@ struct py_object* py_list_slice(
 	if(high < low) high = low;
 	else if(high > py_varobject_size(op)) high = py_varobject_size(op);
 
+	/* Made at its final size, with no room to spare. */
 	if(!(np = (void*) py_list_new(high - low))) return 0;
 
 	for(i = low; i < high; i++) {
@@ -5,6 +5,8 @@
 
 /* Method object implementation */
 
+#include <python/alloc.h>
+
 #include <python/object/method.h>
 
 struct py_object* py_method_new(py_method_t method, struct py_object* self) {
@@ -22,4 +24,6 @@ struct py_object* py_method_new(py_method_t method, struct py_object* self) {
 
 void py_method_dealloc(struct py_object* op) {
 	py_object_decref(((struct py_method*) op)->self);
+
+	py_free(op);
 }
@@ -6,6 +6,7 @@
 /* Module object implementation */
 
 #include <python/std.h>
+#include <python/alloc.h>
 #include <python/import.h>
 #include <python/state.h>
 
@@ -20,13 +21,11 @@ struct py_object* py_module_new(const char* name) {
 
 	if(!(m = py_object_new(PY_TYPE_MODULE))) return 0;
 
-	if(!(m->name = py_string_new(name))) {
-		py_object_decref(m);
-		return 0;
-	}
+	/* So that py_module_dealloc can take apart a half-made module. */
+	m->name = 0;
+	m->attr = 0;
 
-	if(!(m->attr = py_dict_new())) {
-		py_object_decref(m->name);
+	if(!(m->name = py_string_intern(name)) || !(m->attr = py_dict_new())) {
 		py_object_decref(m);
 		return 0;
 	}
@@ -65,7 +64,9 @@ void py_module_dealloc(struct py_object* op) {
 	struct py_module* m = (void*) op;
 
 	py_object_decref(m->name);
-	py_object_decref(m->attr);
+	py_object_release(m->attr);
+
+	py_free(op);
 }
 
 struct py_object* py_module_get_attr(struct py_object* op, const char* name) {
@@ -77,3 +78,13 @@ struct py_object* py_module_get_attr(struct py_object* op, const char* name) {
 
 	return py_object_incref(py_dict_lookup(m->attr, name));
 }
+
+int py_module_set_attr(
+		struct py_object* op, struct py_object* name, struct py_object* v) {
+
+	struct py_module* m = (void*) op;
+
+	if(!v) return py_dict_remove_key(m->attr, name);
+
+	return py_dict_insert_key(m->attr, name, v);
+}
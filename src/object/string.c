@@ -6,22 +6,76 @@
 /* String object implementation */
 
 #include <python/std.h>
+#include <python/alloc.h>
+#include <python/errors.h>
 
 #include <python/object/string.h>
+#include <python/object/list.h>
+#include <python/object/tuple.h>
 
-struct py_object* py_string_new_size(const char* str, unsigned size) {
+/*
+ * Tails of at least this many characters are made views, as long as they
+ * keep at least half of the characters of their base in use -- a short
+ * tail of a long string is copied, so as not to hold on to the whole of it.
+ * Taking s[1:] over and over thus copies each character at most twice.
+ */
+#define PY_STRING_VIEW_MIN (32)
+
+/* TODO: Python global state. */
+static struct py_object* py_string_empty = NULL;
+static struct py_object* py_string_chars[UCHAR_MAX + 1];
+
+static struct py_string* py_string_alloc(unsigned size) {
 	struct py_string* op;
 
-	if(!(op = malloc(sizeof(struct py_string) + size))) return 0;
+	if(!(op = py_malloc(sizeof(struct py_string) + size))) {
+		py_error_set_nomem();
+		return 0;
+	}
 
 	py_object_newref(op);
 	op->ob.type = PY_TYPE_STRING;
 	op->ob.size = size;
-
-	memcpy(op->value, str, size);
+	op->offset = 0;
+	op->hash = -1;
+	op->base = 0;
+	op->allocated = size;
 
 	op->value[size] = '\0';
 
+	return op;
+}
+
+static struct py_object* py_string_char(unsigned char c) {
+	struct py_string* op;
+
+	if(py_string_chars[c]) return py_object_incref(py_string_chars[c]);
+
+	if(!(op = py_string_alloc(1))) return 0;
+	op->value[0] = (char) c;
+
+	py_string_chars[c] = py_object_incref(op);
+
+	return (void*) op;
+}
+
+struct py_object* py_string_new_size(const char* str, unsigned size) {
+	struct py_string* op;
+
+	if(str && size == 1) return py_string_char((unsigned char) *str);
+
+	if(size == 0) {
+		if(!py_string_empty && !(py_string_empty = (void*) py_string_alloc(0))) {
+			return 0;
+		}
+
+		return py_object_incref(py_string_empty);
+	}
+
+	if(!(op = py_string_alloc(size))) return 0;
+
+	if(str) memcpy(op->value, str, size);
+
 	return (void*) op;
 }
 
@@ -30,7 +84,16 @@ struct py_object* py_string_new(const char* str) {
 }
 
 const char* py_string_get(const struct py_object* op) {
-	return ((struct py_string*) op)->value;
+	const struct py_string* sp = (const struct py_string*) op;
+
+	if(sp->base) return sp->base->value + sp->offset;
+
+	return sp->value;
+}
+
+void py_string_dealloc(struct py_object* op) {
+	py_object_decref(((struct py_string*) op)->base);
+	py_free(op);
 }
 
 /* Methods */
@@ -46,17 +109,195 @@ struct py_object* py_string_cat(struct py_object* a, struct py_object* b) {
 	if(sz_a == 0) return py_object_incref(b);
 	if(sz_b == 0) return py_object_incref(a);
 
-	/* TODO: Not using _new_size? */
-	if(!(op = malloc(sizeof(struct py_string) + size))) return 0;
-
-	py_object_newref(op);
-	op->ob.type = PY_TYPE_STRING;
-	op->ob.size = size;
+	if(!(op = py_string_alloc(size))) return 0;
 
 	memcpy(op->value, py_string_get(a), sz_a);
 	memcpy(op->value + sz_a, py_string_get(b), sz_b);
 
+	return (void*) op;
+}
+
+struct py_object* py_string_extend(struct py_object* a, struct py_object* b) {
+	struct py_string* op = (void*) a;
+	unsigned sz_a = py_varobject_size(a);
+	unsigned sz_b = py_varobject_size(b);
+	unsigned size = sz_a + sz_b;
+
+	if(size < sz_a) {
+		py_error_set_nomem();
+		return 0;
+	}
+
+	if(size > op->allocated) {
+		struct py_string* sp;
+		unsigned allocated = size + (size >> 1) + 16;
+
+		if(allocated < size) allocated = size;
+
+		sp = py_realloc(op, sizeof(struct py_string) + allocated);
+		if(!sp) {
+			py_error_set_nomem();
+			return 0;
+		}
+
+		op = sp;
+		op->allocated = allocated;
+	}
+
+	memcpy(op->value + sz_a, py_string_get(b), sz_b);
 	op->value[size] = '\0';
+	op->ob.size = size;
+	op->hash = -1;
+
+	return (void*) op;
+}
+
+struct py_object* py_string_builder_new(unsigned hint) {
+	struct py_string_builder* bp;
+
+	if(!(bp = py_object_new(PY_TYPE_STRING_BUILDER))) return 0;
+
+	bp->str = 0;
+	bp->allocated = 0;
+
+	if(hint) {
+		if(!(bp->str = py_string_alloc(hint))) {
+			py_free(bp);
+			return 0;
+		}
+
+		bp->str->ob.size = 0;
+		bp->allocated = hint;
+	}
+
+	return (void*) bp;
+}
+
+int py_string_builder_append(
+		struct py_object* op, const char* str, unsigned size) {
+
+	struct py_string_builder* bp = (void*) op;
+	unsigned used = bp->str ? bp->str->ob.size : 0;
+
+	if(size > bp->allocated - used) {
+		struct py_string* sp;
+		unsigned need = used + size;
+		unsigned allocated = need + (need >> 1) + 16;
+
+		if(need < used || allocated < need) {
+			py_error_set_nomem();
+			return -1;
+		}
+
+		if(!bp->str) {
+			if(!(bp->str = py_string_alloc(allocated))) return -1;
+			bp->str->ob.size = 0;
+		}
+		else {
+			sp = py_realloc(bp->str, sizeof(struct py_string) + allocated);
+			if(!sp) {
+				py_error_set_nomem();
+				return -1;
+			}
+
+			bp->str = sp;
+		}
+
+		bp->allocated = allocated;
+	}
+
+	memcpy(bp->str->value + used, str, size);
+	bp->str->ob.size = used + size;
+
+	return 0;
+}
+
+struct py_object* py_string_builder_finish(struct py_object* op) {
+	struct py_string_builder* bp = (void*) op;
+	struct py_string* sp = bp->str;
+	struct py_string* shrunk;
+
+	/* Very short strings are shared ones (see py_string_new_size). */
+	if(!sp) return py_string_new_size(0, 0);
+
+	if(sp->ob.size < 2) {
+		struct py_object* res;
+
+		if(!(res = py_string_new_size(sp->value, sp->ob.size))) return 0;
+
+		py_object_decref(sp);
+		bp->str = 0;
+		bp->allocated = 0;
+
+		return res;
+	}
+
+	sp->value[sp->ob.size] = '\0';
+
+	/* Give back the spare room; this doesn't usually move the string. */
+	shrunk = py_realloc(sp, sizeof(struct py_string) + sp->ob.size);
+	if(shrunk) {
+		sp = shrunk;
+		sp->allocated = sp->ob.size;
+	}
+	else sp->allocated = bp->allocated;
+
+	bp->str = 0;
+	bp->allocated = 0;
+
+	return (void*) sp;
+}
+
+void py_string_builder_dealloc(struct py_object* op) {
+	py_object_decref(((struct py_string_builder*) op)->str);
+	py_free(op);
+}
+
+struct py_object* py_string_join(struct py_object* sep, struct py_object* v) {
+	struct py_object** items;
+	struct py_string* op;
+	unsigned i, n = py_varobject_size(v);
+	unsigned sepsize = py_varobject_size(sep);
+	unsigned size = 0;
+	char* p;
+
+	if(v->type == PY_TYPE_LIST) items = ((struct py_list*) v)->item;
+	else if(v->type == PY_TYPE_TUPLE) items = ((struct py_tuple*) v)->item;
+	else {
+		py_error_set_badarg();
+		return 0;
+	}
+
+	if(n == 0) return py_string_new_size(0, 0);
+
+	for(i = 0; i < n; i++) {
+		if(items[i]->type != PY_TYPE_STRING) {
+			py_error_set_string(
+					py_type_error, "join() needs a sequence of strings");
+			return 0;
+		}
+
+		size += py_varobject_size(items[i]);
+		if(i) size += sepsize;
+	}
+
+	if(n == 1) return py_object_incref(items[0]);
+
+	if(!(op = py_string_alloc(size))) return 0;
+
+	p = op->value;
+
+	for(i = 0; i < n; i++) {
+		unsigned len = py_varobject_size(items[i]);
+
+		if(i) {
+			memcpy(p, py_string_get(sep), sepsize);
+			p += sepsize;
+		}
+
+		memcpy(p, py_string_get(items[i]), len);
+		p += len;
+	}
 
 	return (void*) op;
 }
@@ -66,18 +307,299 @@ struct py_object* py_string_cat(struct py_object* a, struct py_object* b) {
 struct py_object* py_string_slice(
 		struct py_object* op, unsigned i, unsigned j) {
 
-	if(j > py_varobject_size(op)) j = py_varobject_size(op);
+	struct py_string* sp = (struct py_string*) op;
+	struct py_string* base;
+	struct py_string* vp;
+	unsigned size = sp->ob.size;
+
+	if(j > size) j = size;
 
 	/* It's the same as op */
-	if(i == 0 && j == py_varobject_size(op)) return py_object_incref(op);
+	if(i == 0 && j == size) return py_object_incref(op);
 
 	if(j < i) j = i;
 
-	return py_string_new_size(py_string_get(op) + i, j - i);
+	base = sp->base ? sp->base : sp;
+
+	if(j != size || j - i < PY_STRING_VIEW_MIN || (j - i) * 2 < base->ob.size) {
+		return py_string_new_size(py_string_get(op) + i, j - i);
+	}
+
+	if(!(vp = py_malloc(sizeof(struct py_string)))) {
+		return py_error_set_nomem();
+	}
+
+	py_object_newref(vp);
+	vp->ob.type = PY_TYPE_STRING;
+	vp->ob.size = j - i;
+	vp->offset = sp->offset + i;
+	vp->hash = -1;
+	vp->base = py_object_incref(base);
+	vp->allocated = 0;
+
+	return (void*) vp;
 }
 
 struct py_object* py_string_ind(struct py_object* a, unsigned i) {
-	return py_string_slice(a, i, i + 1);
+	return py_string_char((unsigned char) py_string_get(a)[i]);
+}
+
+/*
+ * Substring search is the Two-Way algorithm of Crochemore and Perrin,
+ * which runs in linear time and constant space whatever the input. The
+ * needle is cut at a critical position into u and v; v is matched left to
+ * right, then u right to left, and on a mismatch the window moves by the
+ * amount matched so far or by the needle's period. For a periodic needle
+ * the prefix already known to match after such a shift (`memory') isn't
+ * compared again.
+ */
+
+/*
+ * The start of the maximal suffix of x under the alphabet order (or its
+ * reverse), with its period in *period.
+ */
+static long py_string_max_suffix(
+		const unsigned char* x, long m, int reverse, long* period) {
+
+	long ms = -1; /* The suffix starts after this */
+	long j = 0;
+	long k = 1;
+	long p = 1;
+
+	while(j + k < m) {
+		unsigned char a = x[j + k];
+		unsigned char b = x[ms + k];
+
+		if(reverse ? a > b : a < b) {
+			j += k;
+			k = 1;
+			p = j - ms;
+		}
+		else if(a == b) {
+			if(k != p) k++;
+			else {
+				j += p;
+				k = 1;
+			}
+		}
+		else {
+			ms = j;
+			j = ms + 1;
+			k = p = 1;
+		}
+	}
+
+	*period = p;
+
+	return ms;
+}
+
+static long py_string_two_way(
+		const unsigned char* y, long n, const unsigned char* x, long m) {
+
+	long ell, per, p1, p2, ms1, ms2;
+	long i, j;
+
+	if(m > n) return -1;
+
+	ms1 = py_string_max_suffix(x, m, 0, &p1);
+	ms2 = py_string_max_suffix(x, m, 1, &p2);
+
+	if(ms1 > ms2) {
+		ell = ms1;
+		per = p1;
+	}
+	else {
+		ell = ms2;
+		per = p2;
+	}
+
+	if(ell + 1 + per <= m && !memcmp(x, x + per, ell + 1)) {
+		long memory = -1;
+
+		for(j = 0; j <= n - m;) {
+			i = (ell > memory ? ell : memory) + 1;
+			while(i < m && x[i] == y[i + j]) i++;
+
+			if(i < m) {
+				j += i - ell;
+				memory = -1;
+				continue;
+			}
+
+			i = ell;
+			while(i > memory && x[i] == y[i + j]) i--;
+
+			if(i <= memory) return j;
+
+			j += per;
+			memory = m - per - 1;
+		}
+	}
+	else {
+		per = (ell + 1 > m - ell - 1 ? ell + 1 : m - ell - 1) + 1;
+
+		for(j = 0; j <= n - m;) {
+			i = ell + 1;
+			while(i < m && x[i] == y[i + j]) i++;
+
+			if(i < m) {
+				j += i - ell;
+				continue;
+			}
+
+			i = ell;
+			while(i >= 0 && x[i] == y[i + j]) i--;
+
+			if(i < 0) return j;
+
+			j += per;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Ahead of Two-Way, a vector filter looks at 16 or 32 offsets at a time
+ * and only compares the needle in full where its first and last characters
+ * both match. That skips over ordinary text far faster, but repetitive
+ * text can make most offsets false leads; once these have cost more than
+ * twice the distance covered the filter gives up, and Two-Way (which is
+ * linear whatever happens) does the rest. Single characters go to memchr,
+ * which the C library vectorises already. PY_NO_SIMD builds go without.
+ */
+#if !defined(PY_NO_SIMD) && defined(__GNUC__) && \
+	(defined(__x86_64__) || defined(__i386__))
+# define PY_STRING_SIMD
+# include <immintrin.h>
+# define PY_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#ifdef PY_STRING_SIMD
+enum py_string_isa {
+	PY_STRING_ISA_UNKNOWN,
+	PY_STRING_ISA_SCALAR,
+	PY_STRING_ISA_SSE2,
+	PY_STRING_ISA_AVX2
+};
+
+/* TODO: Python global state. */
+static enum py_string_isa py_string_isa = PY_STRING_ISA_UNKNOWN;
+
+static enum py_string_isa py_string_get_isa(void) {
+	if(py_string_isa == PY_STRING_ISA_UNKNOWN) {
+		__builtin_cpu_init();
+
+		if(__builtin_cpu_supports("avx2")) py_string_isa = PY_STRING_ISA_AVX2;
+		else if(__builtin_cpu_supports("sse2")) {
+			py_string_isa = PY_STRING_ISA_SSE2;
+		}
+		else py_string_isa = PY_STRING_ISA_SCALAR;
+	}
+
+	return py_string_isa;
+}
+
+/*
+ * Look for x (m >= 2) at the offsets of y from *pj on. Returns where it is
+ * found, or -1 with *pj at the first offset not ruled out.
+ */
+static PY_TARGET("sse2") long py_string_filter_sse2(
+		const unsigned char* y, long n, const unsigned char* x, long m,
+		long* pj) {
+
+	__m128i first = _mm_set1_epi8((char) x[0]);
+	__m128i last = _mm_set1_epi8((char) x[m - 1]);
+	long j, work = 0;
+
+	for(j = *pj; j + m + 15 <= n && work <= 2 * j + 4096; j += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*) (y + j));
+		__m128i b = _mm_loadu_si128((const __m128i*) (y + j + m - 1));
+		unsigned mask = (unsigned) _mm_movemask_epi8(_mm_and_si128(
+				_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+
+		for(; mask; mask &= mask - 1) {
+			long k = j + __builtin_ctz(mask);
+
+			if(!memcmp(y + k + 1, x + 1, m - 2)) return k;
+			work += m;
+		}
+	}
+
+	*pj = j;
+
+	return -1;
+}
+
+static PY_TARGET("avx2") long py_string_filter_avx2(
+		const unsigned char* y, long n, const unsigned char* x, long m,
+		long* pj) {
+
+	__m256i first = _mm256_set1_epi8((char) x[0]);
+	__m256i last = _mm256_set1_epi8((char) x[m - 1]);
+	long j, work = 0;
+
+	for(j = *pj; j + m + 31 <= n && work <= 2 * j + 4096; j += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i*) (y + j));
+		__m256i b = _mm256_loadu_si256((const __m256i*) (y + j + m - 1));
+		unsigned mask = (unsigned) _mm256_movemask_epi8(_mm256_and_si256(
+				_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+
+		for(; mask; mask &= mask - 1) {
+			long k = j + __builtin_ctz(mask);
+
+			if(!memcmp(y + k + 1, x + 1, m - 2)) return k;
+			work += m;
+		}
+	}
+
+	*pj = j;
+
+	return -1;
+}
+#endif
+
+long py_string_search(
+		const char* haystack, unsigned hsize,
+		const char* needle, unsigned nsize) {
+
+	const unsigned char* y = (const unsigned char*) haystack;
+	const unsigned char* x = (const unsigned char*) needle;
+	long n = hsize, m = nsize;
+	long j = 0;
+	long found;
+
+	if(m == 0) return 0;
+	if(m > n) return -1;
+
+	if(m == 1) {
+		const char* p = memchr(haystack, *needle, hsize);
+		return p ? (long) (p - haystack) : -1;
+	}
+
+#ifdef PY_STRING_SIMD
+	switch(py_string_get_isa()) {
+		default: break;
+
+		case PY_STRING_ISA_AVX2: {
+			if((found = py_string_filter_avx2(y, n, x, m, &j)) != -1) {
+				return found;
+			}
+			break;
+		}
+		case PY_STRING_ISA_SSE2: {
+			if((found = py_string_filter_sse2(y, n, x, m, &j)) != -1) {
+				return found;
+			}
+			break;
+		}
+	}
+#endif
+
+	found = py_string_two_way(y + j, n - j, x, m);
+
+	return found == -1 ? -1 : found + j;
 }
 
 int py_string_cmp(const struct py_object* a, const struct py_object* b) {
@@ -93,3 +615,137 @@ int py_string_cmp(const struct py_object* a, const struct py_object* b) {
 
 	return 0;
 }
+
+/* See PY_STRING_HASH_STEP */
+long py_string_hash_size(const char* str, unsigned size) {
+	unsigned long hash = PY_STRING_HASH_INIT;
+
+	while(size--) hash = PY_STRING_HASH_STEP(hash, *str++);
+
+	return PY_STRING_HASH_DONE(hash);
+}
+
+/* Strings are immutable, so the hash is worked out once and kept. */
+long py_string_hash(struct py_object* op) {
+	struct py_string* sp = (struct py_string*) op;
+
+	if(sp->hash == -1) {
+		sp->hash = py_string_hash_size(py_string_get(op), sp->ob.size);
+	}
+
+	return sp->hash;
+}
+
+/*
+ * Identifiers are interned: py_string_intern gives back the one string
+ * object holding a given name, creating it the first time. Names from the
+ * compiler, dict keys given as C strings and the names registered by
+ * modules all go through here, so the dict usually finds a name by
+ * comparing pointers, and each name is only stored once.
+ * The table is open addressed like the dict (see dict.c) and holds a
+ * reference to each string, so interned strings live until
+ * py_done_string.
+ */
+
+#define PY_INTERN_MINSIZE (256)
+
+/* TODO: Python global state. */
+static struct py_string** py_intern_table = NULL;
+static unsigned long py_intern_mask = 0;
+static unsigned long py_intern_used = 0;
+
+static struct py_string** py_intern_look(
+		const char* str, unsigned size, long hash) {
+
+	unsigned long perturb = (unsigned long) hash;
+	unsigned long i = perturb & py_intern_mask;
+
+	for(;;) {
+		struct py_string** pp = &py_intern_table[i];
+		struct py_string* sp = *pp;
+
+		if(!sp) return pp;
+
+		if(sp->hash == hash && sp->ob.size == size) {
+			if(!memcmp(sp->value, str, size)) return pp;
+		}
+
+		perturb >>= 5;
+		i = (i * 5 + 1 + perturb) & py_intern_mask;
+	}
+}
+
+static int py_intern_resize(void) {
+	struct py_string** oldtable = py_intern_table;
+	unsigned long oldsize = oldtable ? py_intern_mask + 1 : 0;
+	unsigned long newsize = oldsize ? oldsize * 2 : PY_INTERN_MINSIZE;
+	unsigned long i;
+
+	py_intern_table = py_calloc(newsize, sizeof(struct py_string*));
+	if(!py_intern_table) {
+		py_intern_table = oldtable;
+		return -1;
+	}
+
+	py_intern_mask = newsize - 1;
+
+	for(i = 0; i < oldsize; ++i) {
+		struct py_string* sp = oldtable[i];
+
+		if(sp) *py_intern_look(sp->value, sp->ob.size, sp->hash) = sp;
+	}
+
+	py_free(oldtable);
+
+	return 0;
+}
+
+struct py_object* py_string_intern_size(const char* str, unsigned size) {
+	struct py_string** pp;
+	struct py_object* op;
+	long hash = py_string_hash_size(str, size);
+
+	/* Keep the table at most half full. */
+	if(!py_intern_table || (py_intern_used + 1) * 2 > py_intern_mask + 1) {
+		if(py_intern_resize() == -1) return py_error_set_nomem();
+	}
+
+	pp = py_intern_look(str, size, hash);
+
+	if(*pp) return py_object_incref(*pp);
+
+	if(!(op = py_string_new_size(str, size))) return 0;
+
+	((struct py_string*) op)->hash = hash;
+
+	*pp = py_object_incref(op);
+	py_intern_used++;
+
+	return op;
+}
+
+struct py_object* py_string_intern(const char* str) {
+	return py_string_intern_size(str, (unsigned) strlen(str));
+}
+
+void py_done_string(void) {
+	unsigned long i;
+
+	for(i = 0; i <= UCHAR_MAX; ++i) {
+		py_object_decref(py_string_chars[i]);
+		py_string_chars[i] = 0;
+	}
+
+	py_object_decref(py_string_empty);
+	py_string_empty = 0;
+
+	if(!py_intern_table) return;
+
+	for(i = 0; i <= py_intern_mask; ++i) py_object_decref(py_intern_table[i]);
+
+	py_free(py_intern_table);
+
+	py_intern_table = NULL;
+	py_intern_mask = 0;
+	py_intern_used = 0;
+}
@@ -6,19 +6,50 @@
 /* Tuple object implementation */
 
 #include <python/std.h>
+#include <python/alloc.h>
+#include <python/errors.h>
 
 #include <python/object/tuple.h>
 
+/*
+ * Small tuples are made and dropped all the time (argument lists, for
+ * one), so deallocated tuples shorter than PY_TUPLE_MAXSAVESIZE are kept
+ * on a free list per length, linked through their first item, for
+ * py_tuple_new to reuse. There is only ever one empty tuple.
+ */
+
+#define PY_TUPLE_MAXSAVESIZE (20)
+#define PY_TUPLE_MAXFREELIST (2000) /* Per length */
+
+/* TODO: Python global state. */
+static struct py_tuple* py_tuple_freelist[PY_TUPLE_MAXSAVESIZE];
+static unsigned py_tuple_numfree[PY_TUPLE_MAXSAVESIZE];
+static struct py_tuple* py_tuple_empty;
+
 struct py_object* py_tuple_new(unsigned size) {
 	struct py_tuple* op;
 
-	op = calloc(1, sizeof(struct py_tuple) + size * sizeof(struct py_object*));
-	if(!op) return 0;
+	if(size == 0 && py_tuple_empty) return py_object_incref(py_tuple_empty);
+
+	if(size < PY_TUPLE_MAXSAVESIZE && (op = py_tuple_freelist[size])) {
+		py_tuple_freelist[size] = (struct py_tuple*) op->item[0];
+		py_tuple_numfree[size]--;
+
+		memset(op->item, 0, size * sizeof(struct py_object*));
+	}
+	else {
+		op = py_calloc(
+				1, sizeof(struct py_tuple) + size * sizeof(struct py_object*));
+		if(!op) return py_error_set_nomem();
+	}
 
 	py_object_newref(op);
 	op->ob.type = PY_TYPE_TUPLE;
 	op->ob.size = size;
 
+	/* The empty tuple keeps a reference to itself, so it's never freed. */
+	if(size == 0) py_tuple_empty = py_object_incref(op);
+
 	return (void*) op;
 }
 
@@ -36,13 +67,43 @@ void py_tuple_set(struct py_object* op, unsigned i, struct py_object* item) {
 /* Methods */
 
 void py_tuple_dealloc(struct py_object* op) {
+	struct py_tuple* tp = (void*) op;
+	unsigned size = py_varobject_size(op);
+	unsigned i;
+
+	for(i = 0; i < size; i++) py_object_release(tp->item[i]);
+
+	if(size && size < PY_TUPLE_MAXSAVESIZE &&
+		py_tuple_numfree[size] < PY_TUPLE_MAXFREELIST) {
+
+		tp->item[0] = (struct py_object*) py_tuple_freelist[size];
+		py_tuple_freelist[size] = tp;
+		py_tuple_numfree[size]++;
+
+		return;
+	}
+
+	py_free(op);
+}
+
+void py_done_tuple(void) {
 	unsigned i;
 
-	for(i = 0; i < py_varobject_size(op); i++) {
-		py_object_decref(((struct py_tuple*) op)->item[i]);
+	for(i = 1; i < PY_TUPLE_MAXSAVESIZE; ++i) {
+		while(py_tuple_freelist[i]) {
+			struct py_tuple* tp = py_tuple_freelist[i];
+
+			py_tuple_freelist[i] = (struct py_tuple*) tp->item[0];
+			py_free(tp);
+		}
+
+		py_tuple_numfree[i] = 0;
 	}
 
-	free(op);
+	if(py_tuple_empty) {
+		py_free(py_tuple_empty);
+		py_tuple_empty = 0;
+	}
 }
 
 int py_tuple_cmp(const struct py_object* v, const struct py_object* w) {
@@ -65,6 +126,23 @@ int py_tuple_cmp(const struct py_object* v, const struct py_object* w) {
 	return (int) (a - b);
 }
 
+long py_tuple_hash(struct py_object* op) {
+	unsigned long hash = 0x345678UL;
+	unsigned n = py_varobject_size(op);
+	unsigned i;
+
+	for(i = 0; i < n; i++) {
+		long item = py_object_hash(((struct py_tuple*) op)->item[i]);
+		if(item == -1) return -1;
+
+		hash = (1000003UL * hash) ^ (unsigned long) item;
+	}
+
+	hash ^= n;
+
+	return (long) hash == -1 ? -2 : (long) hash;
+}
+
 struct py_object* py_tuple_ind(struct py_object* op, unsigned i) {
 	return py_object_incref(((struct py_tuple*) op)->item[i]);
 }
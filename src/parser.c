@@ -10,6 +10,7 @@
 /* TODO: error recovery */
 
 #include <python/std.h>
+#include <python/alloc.h>
 #include <python/token.h>
 #include <python/grammar.h>
 #include <python/node.h>
@@ -75,14 +76,14 @@ struct py_parser* py_parser_new(struct py_grammar* g, int start) {
 	if(!g->accel) {
 		py_grammar_add_accels(g);
 	}
-	ps = malloc(sizeof(struct py_parser));
+	ps = py_malloc(sizeof(struct py_parser));
 	if(ps == NULL) {
 		return NULL;
 	}
 	ps->grammar = g;
 	ps->tree = py_tree_new(start);
 	if(ps->tree == NULL) {
-		free(ps);
+		py_free(ps);
 		return NULL;
 	}
 	py_stack_reset(&ps->stack);
@@ -96,7 +97,7 @@ void py_parser_delete(struct py_parser* ps) {
 	 * calling py_parser_delete!
 	 */
 	py_tree_delete(ps->tree);
-	free(ps);
+	py_free(ps);
 }
 
 
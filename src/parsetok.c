@@ -6,6 +6,7 @@
 /* Parser-tokenizer link implementation */
 
 #include <python/std.h>
+#include <python/alloc.h>
 #include <python/tokenizer.h>
 #include <python/node.h>
 #include <python/grammar.h>
@@ -47,7 +48,7 @@ static int py_parse_token(
 		 * TODO: Do these need to be malloc'd? Can node tree strs just be refs
 		 * 		 (or even just offsets?)
 		 */
-		str = malloc((len + 1) * sizeof(char));
+		str = py_malloc((len + 1) * sizeof(char));
 		if(str == NULL) {
 			fprintf(stderr, "no mem for next token\n");
 			ret = PY_RESULT_OOM;
@@ -61,8 +62,13 @@ static int py_parse_token(
 				*n_ret = ps->tree;
 				ps->tree = NULL;
 			}
-			else if(tok->lineno <= 1 && tok->done == PY_RESULT_EOF) {
-				ret = PY_RESULT_EOF;
+			else {
+				/* The tree only takes the string if the token was shifted. */
+				py_free(str);
+
+				if(tok->lineno <= 1 && tok->done == PY_RESULT_EOF) {
+					ret = PY_RESULT_EOF;
+				}
 			}
 			break;
 		}
@@ -4,6 +4,7 @@
  */
 
 #include <python/state.h>
+#include <python/alloc.h>
 
 #include <python/types.h>
 #include <python/object/dict.h>
@@ -65,6 +66,8 @@ static enum py_result py_path_new(const char* path, char*** out) {
 enum py_result py_new(struct py* py, const char* path) {
 	enum py_result res;
 
+	py_allocator_default(&py->allocator);
+
 	if((res = py_types_register(py)) != PY_RESULT_OK) return res;
 	if((res = py_path_new(path, &py->path)) != PY_RESULT_OK) return res;
 
@@ -78,6 +81,11 @@ enum py_result py_delete(struct py* py) {
 
 enum py_result py_env_new(struct py* py, struct py_env* env) {
 	env->py = py;
+	env->allocated = 0;
+	env->limit = 0;
+
+	py_alloc_attach(env);
+	py_env_use(env);
 
 	if(!(env->modules = py_dict_new())) return PY_RESULT_OOM;
 
@@ -85,6 +93,8 @@ enum py_result py_env_new(struct py* py, struct py_env* env) {
 }
 
 enum py_result py_env_delete(struct py_env* env) {
-	(void) env;
+	/* This also stops it being current once it's gone. */
+	py_alloc_detach(env);
+
 	return PY_RESULT_OK;
 }
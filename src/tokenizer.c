@@ -10,6 +10,7 @@
 /* TODO: Need a better interface to report errors than writing to stderr */
 
 #include <python/std.h>
+#include <python/alloc.h>
 #include <python/tokenizer.h>
 #include <python/result.h>
 #include <python/token.h>
@@ -32,7 +33,7 @@ char* py_token_names[] = {
 /* Create and initialize a new tok_state structure */
 
 static struct py_tokenizer* py_tokenizer_new(void) {
-	struct py_tokenizer* tok = malloc(sizeof(struct py_tokenizer));
+	struct py_tokenizer* tok = py_malloc(sizeof(struct py_tokenizer));
 	if(tok == NULL) return NULL;
 
 	tok->buf = tok->cur = tok->end = tok->inp = NULL;
@@ -54,8 +55,8 @@ struct py_tokenizer* py_tokenizer_setup_file(FILE* fp, char* ps1, char* ps2) {
 	struct py_tokenizer* tok = py_tokenizer_new();
 	if(tok == NULL) return NULL;
 
-	if((tok->buf = malloc(BUFSIZ * sizeof(char))) == NULL) {
-		free(tok);
+	if((tok->buf = py_malloc(BUFSIZ * sizeof(char))) == NULL) {
+		py_free(tok);
 		return NULL;
 	}
 
@@ -73,9 +74,9 @@ struct py_tokenizer* py_tokenizer_setup_file(FILE* fp, char* ps1, char* ps2) {
 
 void py_tokenizer_delete(struct py_tokenizer* tok) {
 	/* TODO: really need a separate flag to say 'my buffer' */
-	if(tok->fp != NULL && tok->buf != NULL) free(tok->buf);
+	if(tok->fp != NULL && tok->buf != NULL) py_free(tok->buf);
 
-	free(tok);
+	py_free(tok);
 }
 
 
@@ -99,9 +100,9 @@ static int py_tokenizer_next_character(struct py_tokenizer* tok) {
 			unsigned n = (unsigned) (tok->end - tok->buf);
 			char* new = tok->buf;
 
-			newptr = realloc(new, 2 * n * sizeof(char));
+			newptr = py_realloc(new, 2 * n * sizeof(char));
 			if(newptr == NULL) {
-				free(new);
+				py_free(new);
 				tok->done = PY_RESULT_OOM;
 				return EOF;
 			}
@@ -6,6 +6,7 @@
 /* Traceback implementation */
 
 #include <python/std.h>
+#include <python/alloc.h>
 #include <python/compile.h>
 #include <python/traceback.h>
 #include <python/errors.h>
@@ -21,7 +22,7 @@ static struct py_traceback* py_traceback_new_frame(
 
 	struct py_traceback* tb;
 
-	if(!next || next->ob.type != PY_TYPE_TRACEBACK ||
+	if((next && next->ob.type != PY_TYPE_TRACEBACK) ||
 		!frame || frame->ob.type != PY_TYPE_FRAME) {
 
 		py_error_set_badcall();
@@ -123,4 +124,6 @@ void py_traceback_dealloc(struct py_object* op) {
 
 	py_object_decref(tb->next);
 	py_object_decref(tb->frame);
+
+	py_free(op);
 }
@@ -16,74 +16,208 @@
 #include <python/object/tuple.h>
 #include <python/object/list.h>
 #include <python/object/string.h>
+#include <python/object/array.h>
 #include <python/object/dict.h>
 #include <python/object/int.h>
 #include <python/object/float.h>
 
 struct py_type_info py_types[PY_TYPE_MAX] = {
 		/* Type */
-		{ sizeof(struct py_type_info), 0, 0, 0, 0, 0 },
+		{ sizeof(struct py_type_info), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },
 		/* None */
 		{ 0 },
 
 		/* Class */
-		{ sizeof(struct py_class), py_class_dealloc, 0, 0, 0, 0 },
+		{
+				sizeof(struct py_class),
+				py_class_dealloc, 0, 0, 0, 0,
+				0, 0, py_class_get_attr, 0, 0
+		},
 		/* Class Member */
-		{ sizeof(struct py_class_member), py_class_member_dealloc, 0, 0, 0, 0 },
+		{
+				sizeof(struct py_class_member),
+				py_class_member_dealloc, 0, 0, 0, 0,
+				0, 0, py_class_member_get_attr, py_class_member_set_attr, 0
+		},
 		/* Class Method */
-		{ sizeof(struct py_class_method), py_class_method_dealloc, 0, 0, 0, 0 },
+		{
+				sizeof(struct py_class_method),
+				py_class_method_dealloc, 0, 0, 0, 0,
+				0, 0, 0, 0, 0
+		},
 
 		/* Code */
-		{ sizeof(struct py_code), py_code_dealloc, 0, 0, 0, 0 },
+		{
+				sizeof(struct py_code),
+				py_code_dealloc, 0, 0, 0, 0,
+				0, 0, 0, 0, 0
+		},
 		/* Frame */
-		{ sizeof(struct py_frame), py_frame_dealloc, 0, 0, 0, 0 },
+		{
+				sizeof(struct py_frame),
+				py_frame_dealloc, 0, 0, 0, 0,
+				0, 0, 0, 0, 0
+		},
 		/* Traceback */
-		{ sizeof(struct py_traceback), py_traceback_dealloc, 0, 0, 0, 0 },
+		{
+				sizeof(struct py_traceback),
+				py_traceback_dealloc, 0, 0, 0, 0,
+				0, 0, 0, 0, 0
+		},
 		/* Func */
-		{ sizeof(struct py_func), py_func_dealloc, 0, 0, 0, 0 },
+		{
+				sizeof(struct py_func),
+				py_func_dealloc, 0, 0, 0, 0,
+				0, 0, 0, 0, 0
+		},
 		/* Method */
-		{ sizeof(struct py_method), py_method_dealloc, 0, 0, 0, 0 },
+		{
+				sizeof(struct py_method),
+				py_method_dealloc, 0, 0, 0, 0,
+				0, 0, 0, 0, 0
+		},
 		/* Module */
-		{ sizeof(struct py_module), py_module_dealloc, 0, 0, 0, 0 },
+		{
+				sizeof(struct py_module),
+				py_module_dealloc, 0, 0, 0, 0,
+				0, 0, py_module_get_attr, py_module_set_attr, 0
+		},
 
 		/* Tuple */
 		{
 				sizeof(struct py_tuple),
 				py_tuple_dealloc, py_tuple_cmp,
-				py_tuple_cat, py_tuple_ind, py_tuple_slice
+				py_tuple_cat, py_tuple_ind, py_tuple_slice,
+				0, py_varobject_truthy, 0, 0, py_tuple_hash
 		},
 		/* List */
 		{
 				sizeof(struct py_list),
 				py_list_dealloc, py_list_cmp,
-				py_list_cat, py_list_ind, py_list_slice
+				py_list_cat, py_list_ind, py_list_slice,
+				0, py_varobject_truthy, 0, 0, 0
 		},
 		/* String */
 		{
 				sizeof(struct py_string),
-				py_object_delete, py_string_cmp,
-				py_string_cat, py_string_ind, py_string_slice
+				py_string_dealloc, py_string_cmp,
+				py_string_cat, py_string_ind, py_string_slice,
+				0, py_varobject_truthy, 0, 0, py_string_hash
+		},
+		/* Array */
+		{
+				sizeof(struct py_array),
+				py_array_dealloc, py_array_cmp,
+				py_array_cat, py_array_ind, py_array_slice,
+				&py_array_number, py_varobject_truthy, 0, 0, 0
+		},
+		/* String Builder */
+		{
+				sizeof(struct py_string_builder),
+				py_string_builder_dealloc, 0, 0, 0, 0,
+				0, 0, 0, 0, 0
 		},
 
 		/* Dict */
 		{
 				sizeof(struct py_dict),
-				py_dict_dealloc, 0, 0, 0, 0
+				py_dict_dealloc, 0, 0, 0, 0,
+				0, py_dict_truthy, 0, 0, 0
+		},
+		/* Dict View */
+		{
+				sizeof(struct py_dict_view),
+				py_dict_view_dealloc, 0, 0, py_dict_view_ind, 0,
+				0, py_dict_view_truthy, 0, 0, 0
 		},
 
 		/* Int */
 		{
 				sizeof(struct py_int),
-				py_int_dealloc, py_int_cmp, 0, 0, 0
+				py_int_dealloc, py_int_cmp, 0, 0, 0,
+				&py_int_number, py_int_truthy, 0, 0, py_int_hash
 		},
 		/* Float */
 		{
 				sizeof(struct py_float),
-				py_object_delete, py_float_cmp, 0, 0, 0
-		},
+				py_float_dealloc, py_float_cmp, 0, 0, 0,
+				&py_float_number, py_float_truthy, 0, 0, py_float_hash
+		}
+
+		/* User types are filled in by py_type_new. */
 };
 
+/* TODO: Python global state. */
+py_binary_t py_binary_ops[PY_BINARY_MAX][PY_TYPE_MAX][PY_TYPE_MAX];
+
+void py_binary_register(
+		enum py_binary_op op, enum py_type v, enum py_type w, py_binary_t f) {
+
+	py_binary_ops[op][v][w] = f;
+}
+
+/* Fill in the methods for operands of a single type, where not yet set. */
+static void py_binary_register_type(enum py_type tp) {
+	const struct py_number_methods* number = py_types[tp].number;
+	py_binary_t (*ops)[PY_TYPE_MAX][PY_TYPE_MAX] = py_binary_ops;
+
+	if(!ops[PY_BINARY_ADD][tp][tp]) {
+		ops[PY_BINARY_ADD][tp][tp] = number ? number->add : py_types[tp].cat;
+	}
+
+	if(!number) return;
+
+	if(!ops[PY_BINARY_SUB][tp][tp]) ops[PY_BINARY_SUB][tp][tp] = number->sub;
+	if(!ops[PY_BINARY_MUL][tp][tp]) ops[PY_BINARY_MUL][tp][tp] = number->mul;
+	if(!ops[PY_BINARY_DIV][tp][tp]) ops[PY_BINARY_DIV][tp][tp] = number->div;
+	if(!ops[PY_BINARY_MOD][tp][tp]) ops[PY_BINARY_MOD][tp][tp] = number->mod;
+}
+
+enum py_type py_type_new(const struct py_type_info* info) {
+	unsigned tp;
+
+	for(tp = PY_TYPE_USER; tp <= PY_TYPE_USER_LAST; ++tp) {
+		if(py_types[tp].dealloc) continue;
+
+		py_types[tp] = *info;
+		py_binary_register_type((enum py_type) tp);
+
+		return (enum py_type) tp;
+	}
+
+	return PY_TYPE_MAX;
+}
+
 enum py_result py_types_register(struct py* py) {
+	unsigned i;
+
 	(void) py;
+
+	for(i = 0; i < PY_TYPE_MAX; ++i) py_binary_register_type((enum py_type) i);
+
+	/* Integers mixed with floats are done in floating point. */
+	for(i = 0; i < PY_BINARY_MAX; ++i) {
+		py_binary_t (*ops)[PY_TYPE_MAX] = py_binary_ops[i];
+		py_binary_t f = ops[PY_TYPE_FLOAT][PY_TYPE_FLOAT];
+
+		if(!ops[PY_TYPE_INT][PY_TYPE_FLOAT]) ops[PY_TYPE_INT][PY_TYPE_FLOAT] = f;
+		if(!ops[PY_TYPE_FLOAT][PY_TYPE_INT]) ops[PY_TYPE_FLOAT][PY_TYPE_INT] = f;
+	}
+
+	/* Arrays mixed with numbers are done item by item. */
+	for(i = 0; i < PY_BINARY_MAX; ++i) {
+		py_binary_t (*ops)[PY_TYPE_MAX] = py_binary_ops[i];
+		py_binary_t f = ops[PY_TYPE_ARRAY][PY_TYPE_ARRAY];
+
+		if(!ops[PY_TYPE_ARRAY][PY_TYPE_INT]) ops[PY_TYPE_ARRAY][PY_TYPE_INT] = f;
+		if(!ops[PY_TYPE_ARRAY][PY_TYPE_FLOAT]) {
+			ops[PY_TYPE_ARRAY][PY_TYPE_FLOAT] = f;
+		}
+		if(!ops[PY_TYPE_INT][PY_TYPE_ARRAY]) ops[PY_TYPE_INT][PY_TYPE_ARRAY] = f;
+		if(!ops[PY_TYPE_FLOAT][PY_TYPE_ARRAY]) {
+			ops[PY_TYPE_FLOAT][PY_TYPE_ARRAY] = f;
+		}
+	}
+
 	return PY_RESULT_OK;
 }